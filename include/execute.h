@@ -0,0 +1,233 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Execute core header
+//   The instruction set, shared by the processor, the
+//   coroutine engine and the embedded machine.  Each engine
+//   runs its own execution cycle and hands the decode and
+//   execute step to execute_instruction with a CPU policy,
+//   which says how that engine reaches memory and devices:
+//
+//     word                      register and memory word
+//     registers                 register array
+//     fetch_operand()           word at the PC, advancing it
+//     fetch_target()            jump target at the PC
+//     read(a), write(a, v)      checked memory or device access
+//     read_target(a),           access to an address named by
+//     write_target(a, v)        the operand (LOAD_ADDR, STORE)
+//     read_port(p),             device register of IN and PUT
+//     write_port(p, v)
+//     syscall(vector)           interrupt of the SYSCALL op
+//     return_syscall()          SYSRETURN
+//     end(code)                 End, or an invalid opcode
+//
+//   The calls are resolved at compile time, so every engine
+//   gets a dispatch loop specialized to its own memory path.
+
+
+#ifndef _EXECUTE_H_
+#define _EXECUTE_H_
+
+#include <limits>
+#include <type_traits>
+#include "program.h"
+
+/* Push Stack
+ * <cpu> CPU policy
+ * <value> value to push onto the active stack
+ */
+template <typename Cpu>
+inline void push_stack(Cpu &cpu, typename Cpu::word value)
+{
+   typedef typename Cpu::word Word;
+   cpu.registers[SP] = wrapping_sub(cpu.registers[SP], (Word)1);
+   cpu.write(cpu.registers[SP], value);
+}
+
+/* Pop Stack
+ * <cpu> CPU policy
+ * <return> value popped from the active stack
+ */
+template <typename Cpu>
+inline typename Cpu::word pop_stack(Cpu &cpu)
+{
+   typedef typename Cpu::word Word;
+   Word address = cpu.registers[SP];
+   cpu.registers[SP] = wrapping_add(address, (Word)1);
+   return cpu.read(address);
+}
+
+/* Push Registers
+ * Push all registers excluding SP onto the active stack, the
+ * frame of an interrupt.
+ *
+ * <cpu> CPU policy
+ */
+template <typename Cpu>
+inline void push_registers(Cpu &cpu)
+{
+   typedef typename Cpu::word Word;
+   Word *registers = cpu.registers;
+   for(int i = 1; i < REGCOUNT; i++)
+      cpu.write(wrapping_sub(registers[SP], (Word)i), registers[i-1]);
+   registers[SP] = wrapping_sub(registers[SP], (Word)(REGCOUNT - 1));
+}
+
+/* Pop Registers
+ * Pop the frame of push_registers off the active stack.
+ *
+ * <cpu> CPU policy
+ */
+template <typename Cpu>
+inline void pop_registers(Cpu &cpu)
+{
+   typedef typename Cpu::word Word;
+   Word *registers = cpu.registers;
+   for(int i = 1; i < REGCOUNT; i++)
+      registers[i-1] = cpu.read(wrapping_add(registers[SP], (Word)(REGCOUNT - 1 - i)));
+   registers[SP] = wrapping_add(registers[SP], (Word)(REGCOUNT - 1));
+}
+
+/* Execute Instruction
+ * Decode the value in IR register and execute it.  Address
+ * and register arithmetic wraps around at the width of the
+ * word.
+ *
+ * <cpu> CPU policy of the engine
+ */
+template <typename Cpu>
+inline void execute_instruction(Cpu &cpu)
+{
+   typedef typename Cpu::word Word;
+   Word *registers = cpu.registers;
+   Word temp;
+
+   switch(registers[IR])
+   {
+      case LOAD_VAL: registers[AC] = cpu.fetch_operand(); break;
+      case LOAD_ADDR:
+         temp = cpu.fetch_operand();
+	 registers[AC] = cpu.read_target(temp);
+	 break;
+      case LOAD_IND_ADDR:
+         temp = cpu.fetch_operand();
+	 temp = cpu.read(temp);
+	 registers[AC] = cpu.read(temp);
+	 break;
+      case LOAD_IDX_X_ADDR:
+         temp = cpu.fetch_operand();
+	 registers[AC] = cpu.read(wrapping_add(temp, registers[X]));
+	 break;
+      case LOAD_IDX_Y_ADDR:
+         temp = cpu.fetch_operand();
+	 registers[AC] = cpu.read(wrapping_add(temp, registers[Y]));
+	 break;
+      case LOAD_SPX: registers[AC] = cpu.read(wrapping_add(registers[SP], registers[X])); break;
+      case STORE:
+         temp = cpu.fetch_operand();
+	 cpu.write_target(temp, registers[AC]);
+	 break;
+      case GET: registers[AC] = cpu.read(RNG_BASE); break;
+      case PUT:
+         temp = cpu.fetch_operand();
+	 cpu.write_port(temp, registers[AC]);
+	 break;
+      case ADDX: registers[AC] = wrapping_add(registers[AC], registers[X]); break;
+      case ADDY: registers[AC] = wrapping_add(registers[AC], registers[Y]); break;
+      case SUBX: registers[AC] = wrapping_sub(registers[AC], registers[X]); break;
+      case SUBY: registers[AC] = wrapping_sub(registers[AC], registers[Y]); break;
+      case COPY_TO_X: registers[X] = registers[AC]; break;
+      case COPY_FR_X: registers[AC] = registers[X]; break;
+      case COPY_TO_Y: registers[Y] = registers[AC]; break;
+      case COPY_FR_Y: registers[AC] = registers[Y]; break;
+      case COPY_TO_SP: registers[SP] = registers[AC]; break;
+      case COPY_FR_SP: registers[AC] = registers[SP]; break;
+      case JUMP: registers[PC] = cpu.fetch_target(); break;
+      case JUMP_IF_EQ:
+         temp = cpu.fetch_operand();
+	 if(!registers[AC])
+	    registers[PC] = temp;
+	 break;
+      case JUMP_IF_NEQ:
+         temp = cpu.fetch_operand();
+	 if(registers[AC])
+	    registers[PC] = temp;
+	 break;
+      case JUMP_RETURN:
+         push_stack(cpu, wrapping_add(registers[PC], (Word)1));
+	 registers[PC] = cpu.fetch_target();
+	 break;
+      case RETURN: registers[PC] = pop_stack(cpu); break;
+      case INCX: registers[X] = wrapping_add(registers[X], (Word)1); break;
+      case DECX: registers[X] = wrapping_sub(registers[X], (Word)1); break;
+      case PUSH: push_stack(cpu, registers[AC]); break;
+      case POP: registers[AC] = pop_stack(cpu); break;
+      case SYSCALL: cpu.syscall(INT_INDEX); break;
+      case SYSRETURN: cpu.return_syscall(); break;
+      case IN:
+         temp = cpu.fetch_operand();
+	 registers[AC] = cpu.read_port(temp);
+	 break;
+      case END: cpu.end(SUCCESS); break;
+      default: cpu.end(INVALID_OPCODE);
+   }
+}
+
+/* RNG Value
+ * Register 0 of the RNG device, from a draw of the generator.
+ *
+ * <number> non-negative random number
+ * <return> random value between 1-100
+ */
+inline int rng_value(long number)
+{
+   return (number % 100) + 1;
+}
+
+/* Parse Int Token
+ * Value of a whitespace delimited console input token, an
+ * optional '-' and digits up to the first non-digit.  Values
+ * past the range of the word saturate at its largest value.
+ *
+ * <at> byte of the token at an offset
+ * <length> token length, at least 1
+ * <return> integer value
+ */
+template <typename Word, typename Bytes>
+inline Word parse_int_token(Bytes at, size_t length)
+{
+   typedef std::make_unsigned_t<Word> Unsigned;
+   const Unsigned limit = std::numeric_limits<Word>::max();
+
+   bool negative = (at(0) == '-');
+   Unsigned value = 0;
+   for(size_t i = negative ? 1 : 0; i < length; i++)
+   {
+      char byte = at(i);
+      if(byte < '0' || byte > '9')
+         break;
+      Unsigned digit = byte - '0';
+      value = value > (limit - digit) / 10 ? limit : value * 10 + digit;
+   }
+   return negative ? -(Word)value : (Word)value;
+}
+
+#endif
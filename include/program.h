@@ -25,10 +25,43 @@
 #ifndef _PROGRAM_1_H_
 #define _PROGRAM_1_H_
 
+#include <iosfwd>
+#include <string>
+#include <cstddef>
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <type_traits>
+
 // Defined memory size and indices
 #define MEMORY_SIZE 2000
 #define SYS_INDEX 1000
 #define INT_INDEX 1500
+#define INPUT_INDEX 1250
+
+// Interrupt vectors: timer, input and system call
+#define VECTOR_COUNT 3
+
+// Memory-mapped I/O region above main memory, dispatched by page
+#define IO_BASE 2048
+#define IO_SIZE 8192
+#define IO_PAGE_SHIFT 4
+#define IO_PAGE_SIZE (1 << IO_PAGE_SHIFT)
+#define IO_PAGE_MASK (IO_PAGE_SIZE - 1)
+#define MAX_DEVICES 16
+
+// Built-in device base addresses.  PUT and IN ports are
+// offsets from IO_BASE, so they address the console.
+#define CONSOLE_BASE IO_BASE
+#define RNG_BASE (IO_BASE + IO_PAGE_SIZE)
+#define TIMER_BASE (IO_BASE + 2 * IO_PAGE_SIZE)
+#define DISK_BASE (IO_BASE + 3 * IO_PAGE_SIZE)
+#define FB_BASE (IO_BASE + 4 * IO_PAGE_SIZE)
+#define FB_CELLS (IO_BASE + 256)
+
+// Text framebuffer dimensions
+#define FB_WIDTH 80
+#define FB_HEIGHT 25
 
 // Registers
 enum register_values
@@ -54,9 +87,26 @@ enum parse_op
 enum mem_codes
 {
    READ,
-   WRITE
+   WRITE,
+   CLONE,
+   BATCH,
+   FOOTPRINT,
+   DIGEST,
+   DUMP
 };
 
+// One request of a BATCH, on the image of the given VM
+struct mem_request
+{
+   int action;
+   int vm;
+   int address;
+   int value;
+};
+
+// Most VMs interleaved by the coroutine engine
+#define MAX_VMS 1024
+
 // Program return error codes
 enum error_codes
 {
@@ -74,6 +124,9 @@ enum error_codes
    KERNEL_MEM_ACCESS_DENIED,
    USER_MEM_ACCESS_DENIED,
    INVALID_PORT_CALL,
+   INPUT_FAILURE,
+   DISK_FAILURE,
+   MEMORY_ALLOC_FAILURE,
    ERRCOUNT
 };
 
@@ -110,9 +163,32 @@ enum instruction
    POP,
    SYSCALL,
    SYSRETURN,
+   IN,
    END = 50,
 };
 
+// Word arithmetic wraps around in two's complement instead
+// of overflowing, which is undefined for signed host types
+template <typename Word>
+inline Word wrapping_add(Word a, Word b)
+{
+   return (Word)((std::make_unsigned_t<Word>)a + (std::make_unsigned_t<Word>)b);
+}
+
+template <typename Word>
+inline Word wrapping_sub(Word a, Word b)
+{
+   return (Word)((std::make_unsigned_t<Word>)a - (std::make_unsigned_t<Word>)b);
+}
+
+// Backing of large memory arrays
+enum memory_backing
+{
+   BACKING_PAGES,
+   BACKING_THP,
+   BACKING_HUGETLB
+};
+
 // Process Id indices
 enum pid_values
 {
@@ -122,8 +198,350 @@ enum pid_values
 
 };
 
+// Memory-mapped device.  Callbacks get the register offset
+// from the device base and return false for invalid access.
+// Registers whose bit is set in kernel_registers (offsets
+// below 32) are denied to user mode.
+struct device
+{
+   const char *name;
+   int base;
+   int size;
+   bool (*read)(int offset, int *value);
+   bool (*write)(int offset, int value);
+   unsigned int kernel_registers = 0;
+};
+
+// Register bit of the interrupt timer, kernel-only
+#define TIMER_KERNEL_REGISTERS (1u << 1)
+
+// Built-in devices of libsimos (devices.cc, framebuffer.cc).
+// The processor process keeps one of each behind its device
+// bus and every machine has its own.  Word is the register
+// and memory word of the owner.
+namespace simos
+{
+
+// Console input: the input port of the processor process or
+// the input string of a machine
+template <typename Word>
+class console_input
+{
+public:
+   virtual ~console_input() {}
+   virtual Word read_int() = 0;
+   virtual int  read_char() = 0;
+   virtual int  status() = 0;
+   virtual void arm_interrupt() = 0;
+};
+
+// Console input read from a string, as if all of it had
+// arrived, with the readiness interrupt armed by the program
+template <typename Word>
+class string_input : public console_input<Word>
+{
+public:
+   void set_text(const std::string &text);
+   void rewind();
+   Word read_int();
+   int  read_char();
+   int  status();
+   void arm_interrupt();
+
+   bool armed = false;
+
+private:
+   std::string text;
+   size_t position = 0;
+};
+
+// Console: output to a stream, or captured when it is NULL
+template <typename Word>
+class console_device
+{
+public:
+   console_device(console_input<Word> *input, std::ostream *output);
+   void print(const std::string &text);
+   bool read(int offset, Word *value);
+   bool write(int offset, Word value);
+
+   console_input<Word> *input;
+   std::ostream *output;
+   std::string captured;
+};
+
+// RNG: a generator of its own, seeded 1 like rand()
+template <typename Word>
+class rng_device
+{
+public:
+   rng_device();
+   rng_device(const rng_device &) = delete;
+   rng_device &operator=(const rng_device &) = delete;
+   void seed(unsigned int seed);
+   bool read(int offset, Word *value);
+   bool write(int offset, Word value);
+
+private:
+   char state[128];
+   struct random_data data;
+};
+
+// Timer: the interrupt timer and instruction counter of the
+// owner, with a count of the accesses to the timer register
+template <typename Word>
+class timer_device
+{
+public:
+   timer_device(int &interval, std::function<long long()> count);
+   bool read(int offset, Word *value);
+   bool write(int offset, Word value);
+
+   long long accesses = 0;
+
+private:
+   int &interval;
+   std::function<long long()> count;
+};
+
+// Disk: a host file of 32-bit words
+template <typename Word>
+class disk_device
+{
+public:
+   disk_device() {}
+   disk_device(const disk_device &) = delete;
+   disk_device &operator=(const disk_device &) = delete;
+   ~disk_device();
+   bool open(const char *path);
+   bool read(int offset, Word *value);
+   bool write(int offset, Word value);
+
+private:
+   int size();
+
+   int fd = -1;
+   int position = 0;
+};
+
+// Text framebuffer, rendered through a console
+template <typename Word>
+class framebuffer_device
+{
+public:
+   framebuffer_device(console_device<Word> &console);
+   void set_refresh(int interval);
+   void render();
+   bool read(int offset, Word *value);
+   bool write(int offset, Word value);
+   bool cells_read(int offset, Word *value);
+   bool cells_write(int offset, Word value);
+
+   // Called after every instruction.  Fast-forward can jump
+   // the counter past a refresh, which is then taken at the
+   // next tick.
+   void tick(long long count)
+   {
+      if(refresh_interval > 0 && count >= next_refresh)
+         refresh(count);
+   }
+
+private:
+   void refresh(long long count);
+   void putChar(Word value);
+   void clear();
+   bool blankRow(int y);
+
+   console_device<Word> &console;
+
+   // Character cells and dirty row flags
+   Word cells[FB_WIDTH * FB_HEIGHT];
+   bool dirty_rows[FB_HEIGHT];
+   bool dirty = false;
+
+   // Cursor position
+   int cursor_x = 0;
+   int cursor_y = 0;
+
+   // Render every refresh_interval instructions (0 = on
+   // demand) and the instruction count of the next refresh
+   int refresh_interval = 0;
+   long long next_refresh = 0;
+
+   // Set once the screen has been cleared for the first render
+   bool screen_initialized = false;
+};
+
+// Interrupt vector methods
+int  vector_slot(int vector);
+
+// Program loader methods
+bool load_program(const char *file, int image[]);
+bool load_program_stream(std::istream &file_stream, int image[]);
+bool load_program_stream(std::istream &file_stream, long long image[]);
+int  parse_program_line(const char *c_line, size_t length, int &number);
+int  parse_program_line(const char *c_line, size_t length, long long &number);
+
+}
+
+// Registers saved on entry to an interrupt and restored on
+// return (SP is the user stack pointer), with accessors to
+// memory checked for kernel mode
+struct interrupt_frame
+{
+   int vector;
+   int registers[REGCOUNT];
+   int  (*read)(int address);
+   void (*write)(int address, int value);
+};
+
+// Host-native interrupt handler
+typedef void (*native_handler)(interrupt_frame &frame);
+
 // Methods
 void run_main_memory(char* file, int readpipe[], int writepipe[], bool debugMode);
 void run_processor(int timer, int *pid, int writeToMem[], int readFromMem[], bool debugMode);
+void endProcess(int exitCode);
+const char *exit_code_name(int exitCode);
+int  fork_main_memory(char *file, int procToMem[], int memToProc[], bool debugMode);
+
+// Coroutine engine methods
+void run_coroutine_engine(int timer, int vmCount, int *pid, int writeToMem[], int readFromMem[]);
+
+// Decoupled fetch methods
+void set_decoupled_fetch(bool enabled);
+bool open_fetch_channel();
+void serve_fetch_channel();
+void start_fetch_unit(int memoryPid);
+bool fetch_stream_word(int address, int *value);
+void squash_fetch_on_store(int address);
+
+// Memory backing methods
+int *allocate_memory(size_t words, int *backing);
+void release_memory(int *memory, size_t words, int backing);
+const char *backing_name(int backing);
+int  backing_numa_node();
+
+// Process placement methods
+void set_cpu_pinning(int processorCpu, int memoryCpu);
+void set_auto_placement(bool enabled);
+void set_busy_poll(bool enabled);
+void notify_memory(int memoryPid);
+bool wait_for_request(int fd);
+void choose_placement();
+void pin_processor();
+void pin_memory();
+std::string describe_placement();
+
+// Memory hash tree methods
+void merkle_build(const int image[]);
+void merkle_update(int address, int oldValue, int newValue);
+uint64_t merkle_digest();
+
+// Checkpoint methods
+void set_checkpoint_file(const char *path);
+void write_checkpoint(int exitCode);
+uint64_t memory_digest();
+bool dump_memory(int image[]);
+
+// Core dump methods
+void set_core_file(const char *path);
+void retire_instruction(int address);
+void write_core_dump(int exitCode);
+int  analyze_core(const char *file);
+const char *opcode_name(int opcode);
+bool opcode_has_operand(int opcode);
+
+// Live metrics methods
+void set_metrics_name(const char *name);
+void start_metrics();
+void tick_metrics(int count);
+void finish_metrics(int exitCode);
+int  run_simtop(const char *name, int interval);
+long long monotonic_nanos();
+
+// Program profile methods
+void set_profile_file(const char *path);
+void start_profile();
+void profile_retire(int address, int opcode);
+void write_profile();
+
+// Native handler methods
+bool register_native_handler(int vector, native_handler handler);
+native_handler native_handler_at(int vector);
+void native_return(interrupt_frame &frame);
+bool check_native_return(int vector, long long handler);
+
+// Timer sweep methods
+int  run_sweep(int argc, char *argv[]);
+
+// Opcode benchmark methods
+int  run_benchmark(int argc, char *argv[]);
+
+// Run statistics methods
+void set_stats(bool enabled);
+void start_stats();
+void print_stats();
+void stats_retire(int address);
+void stats_skip(int address, long long instructions);
+void stats_interrupt_entry(int vector);
+void stats_handler_start();
+void stats_interrupt_exit();
+void stats_return_to_user();
+
+// Loop fast-forward methods
+void set_fast_forward(bool enabled);
+void record_code_word(int address, int value);
+void invalidate_code_word(int address);
+void fast_forward_loop(int branch);
+
+// Static access analysis flags and methods
+#define OPERAND_SAFE 1
+#define TARGET_SAFE 2
+#define NEXT_SAFE 4
+void set_static_analysis(bool enabled);
+void analyze_program(const char *file);
+int  site_flags_at(int address);
+void invalidate_site(int address);
+
+// Zygote methods
+int  run_zygote(const char *socketPath, int minPool, int maxPool, bool debugMode);
+int  submit_job(const char *socketPath, const char *file, int timer);
+void finish_job(int exitCode);
+
+// Streaming loader methods
+void set_stream_load(bool enabled);
+bool stream_load_enabled();
+bool start_stream_load(const char *file, int image[]);
+bool wait_for_page(int address);
+bool page_is_published(int address);
+bool wait_for_stream_load();
+bool stream_load_pending();
+
+// Memory server methods
+void set_memory_server(const char *socketPath);
+bool attach_memory_server(const char *file);
+int  run_memory_server(const char *socketPath);
+
+// Input port methods
+bool start_input_port(const char *path);
+int  input_port_status();
+int  input_port_read_char();
+int  input_port_read_int();
+void arm_input_interrupt();
+bool input_interrupt_is_armed();
+bool take_input_interrupt();
+
+// Device bus methods
+bool register_device(const device &dev);
+device *find_device(int address);
+bool kernel_register(const device &dev, int address);
+void register_builtin_devices();
+bool start_disk(const char *path);
+
+// Framebuffer methods
+void set_framebuffer_refresh(int interval);
+void tick_framebuffer(int count);
+void render_framebuffer();
 
 #endif
@@ -0,0 +1,204 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   libsimos header
+//   Embedding API of libsimos.a / libsimos.so.  A machine is
+//   one simulated processor with its own main memory and
+//   device bus, run in the calling thread: no processes are
+//   forked and no global state is shared, so any number of
+//   machines can run side by side, one thread per machine.
+//   Only this header is installed; the simulator's own header
+//   (program.h) stays private, so the constants below have
+//   names of their own.
+
+
+#ifndef _SIMOS_H_
+#define _SIMOS_H_
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace simos __attribute__((visibility("default")))
+{
+
+// Main memory: user space below system_base, system space
+// (kernel mode only) up to memory_words
+const int memory_words = 2000;
+const int system_base = 1000;
+
+// Interrupt vectors: timer, input and system call
+const int timer_vector = 1000;
+const int input_vector = 1250;
+const int syscall_vector = 1500;
+
+// Memory-mapped I/O region of the device bus, mapped by page
+const int io_base = 2048;
+const int io_size = 8192;
+const int io_page_words = 16;
+
+// Registers
+enum register_id
+{
+   PC,
+   IR,
+   AC,
+   X,
+   Y,
+   SP,
+   REGCOUNT
+};
+
+// Exit codes of a run
+enum exit_status
+{
+   SUCCESS,
+   CLI_FAILURE,
+   FORK_FAILURE,
+   PIPE_FAILURE,
+   FILE_PARSE_FAILURE,
+   INVALID_OPCODE,
+   PROGRAM_PATH_FAILURE,
+   READ_FAILURE,
+   WRITE_FAILURE,
+   INVALID_MEM_ACTION,
+   MEMORY_OUT_OF_BOUNDS,
+   KERNEL_MEM_ACCESS_DENIED,
+   USER_MEM_ACCESS_DENIED,
+   INVALID_PORT_CALL,
+   INPUT_FAILURE,
+   DISK_FAILURE,
+   MEMORY_ALLOC_FAILURE,
+   ERRCOUNT
+};
+
+// Memory-mapped device of a machine.  Callbacks get the
+// register offset from the device base and return false for
+// an invalid access, which ends the run with INVALID_PORT_CALL.
+// Registers whose bit is set in kernel_registers (offsets
+// below 32) end a user mode access with
+// KERNEL_MEM_ACCESS_DENIED.
+template <typename Word>
+struct basic_device
+{
+   std::string name;
+   int base;
+   int size;
+   std::function<bool(int offset, Word *value)> read;
+   std::function<bool(int offset, Word value)> write;
+   unsigned int kernel_registers = 0;
+};
+
+// Registers saved on entry to an interrupt and restored on
+// return (SP is the user stack pointer), with accessors to
+// memory checked for kernel mode
+template <typename Word>
+struct basic_native_frame
+{
+   int vector;
+   Word registers[REGCOUNT];
+   std::function<Word(Word address)> read;
+   std::function<void(Word address, Word value)> write;
+};
+
+// Simulated machine.  Runs the same instruction set, modes,
+// stacks, interrupts and built-in devices as the processor
+// process, with main memory as a local array.  The console
+// output is captured or sent to a stream, and its input read
+// from a string; the framebuffer prints on the console.  Word
+// is the register and memory word, int or long long;
+// arithmetic wraps around at its width.
+template <typename Word>
+class basic_machine
+{
+public:
+   typedef basic_device<Word> device;
+   typedef basic_native_frame<Word> native_frame;
+   typedef std::function<void(native_frame &frame)> interrupt_handler;
+
+   basic_machine();
+   ~basic_machine();
+   basic_machine(const basic_machine &) = delete;
+   basic_machine &operator=(const basic_machine &) = delete;
+
+   // Load a program, replacing memory and resetting the CPU
+   bool load_file(const std::string &file);
+   bool load_stream(std::istream &program);
+   bool load_image(const std::vector<Word> &image);
+   void reset();
+
+   // Configuration
+   void set_timer(int instructions);
+   void set_seed(unsigned int seed);
+   void set_input(const std::string &text);
+   void set_output(std::ostream *stream);
+   bool set_disk(const std::string &file);
+   void set_framebuffer_refresh(int instructions);
+   bool register_device(const device &dev);
+   bool set_native_handler(int vector, interrupt_handler handler);
+
+   // Execution: one instruction, or up to count of them
+   bool step();
+   long long run(long long count);
+
+   // State inspection
+   bool halted() const;
+   int  exit_code() const;
+   Word reg(register_id r) const;
+   void set_reg(register_id r, Word value);
+   Word peek(int address) const;
+   void poke(int address, Word value);
+   bool kernel_mode() const;
+   bool interrupts_enabled() const;
+   int  timer() const;
+   long long instructions() const;
+   long long interrupts() const;
+   long long timer_accesses() const;
+   const std::string &output() const;
+   void clear_output();
+
+private:
+   // Registers, memory and devices, in machine.cc
+   struct state;
+   std::unique_ptr<state> self;
+};
+
+// Both word widths are built into libsimos
+extern template class basic_machine<int>;
+extern template class basic_machine<long long>;
+
+// 32-bit machine, the word of the processor process
+typedef basic_machine<int> machine;
+typedef machine::device device;
+typedef machine::native_frame native_frame;
+typedef machine::interrupt_handler interrupt_handler;
+
+// 64-bit machine
+typedef basic_machine<long long> machine64;
+typedef machine64::device device64;
+typedef machine64::native_frame native_frame64;
+typedef machine64::interrupt_handler interrupt_handler64;
+
+}
+
+#endif
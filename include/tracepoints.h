@@ -0,0 +1,51 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Tracepoints header
+//   Static tracepoints of the "simos" provider.  Built on
+//   <sys/sdt.h> when it is installed (systemtap-sdt-dev), so
+//   each probe is a nop plus an ELF note that perf, bpftrace
+//   or SystemTap patch at attach time.  Without the header,
+//   or with -DNO_TRACEPOINTS, the probes compile to nothing
+//   but still use their arguments.
+
+
+#ifndef _TRACEPOINTS_H_
+#define _TRACEPOINTS_H_
+
+#if !defined(NO_TRACEPOINTS) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HAVE_TRACEPOINTS 1
+#endif
+#endif
+
+#ifdef HAVE_TRACEPOINTS
+#define TRACE_PROBE1(name, a) STAP_PROBE1(simos, name, a)
+#define TRACE_PROBE2(name, a, b) STAP_PROBE2(simos, name, a, b)
+#define TRACE_PROBE3(name, a, b, c) STAP_PROBE3(simos, name, a, b, c)
+#else
+#define TRACE_PROBE1(name, a) do { (void)(a); } while(0)
+#define TRACE_PROBE2(name, a, b) do { (void)(a); (void)(b); } while(0)
+#define TRACE_PROBE3(name, a, b, c) do { (void)(a); (void)(b); (void)(c); } while(0)
+#endif
+
+#endif
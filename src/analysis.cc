@@ -0,0 +1,185 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Static Access Analysis
+//   Implementation below is executed by the processor process
+//   at load time.  Walks the program from the user entry point
+//   and the interrupt vectors and proves, per instruction, which
+//   of its memory accesses are always in bounds for its mode.
+//   An instruction can only be fetched in the mode matching its
+//   region (user below SYS_INDEX, kernel above), so the mode of
+//   every instruction is known statically.  Proven accesses use
+//   the unchecked memory handlers; indexed, indirect and stack
+//   accesses are never proven and keep their checks.
+
+#include <vector>
+#include "program.h"
+using namespace std;
+
+// Methods
+bool sameRegion(int address, int other);
+
+// Proven accesses per instruction address
+unsigned char site_flags[MEMORY_SIZE];
+
+// Analysis enabled flag
+bool static_analysis = false;
+
+/* Set Static Analysis
+ * <enabled> enable elision of proven access checks
+ */
+void set_static_analysis(bool enabled)
+{
+   static_analysis = enabled;
+}
+
+/* Analyze Program
+ * Loads the program image and computes the proven accesses
+ * of every instruction reachable through static control flow.
+ * Leaves every access checked if the image cannot be loaded.
+ *
+ * <file> input file path
+ */
+void analyze_program(const char *file)
+{
+   if(!static_analysis)
+      return;
+
+   vector<int> image(MEMORY_SIZE, 0);
+   if(!simos::load_program(file, &image[0]))
+      return;
+
+   // Entry points: user program and interrupt vectors
+   vector<bool> visited(MEMORY_SIZE, false);
+   vector<int> worklist;
+   worklist.push_back(0);
+   worklist.push_back(SYS_INDEX);
+   worklist.push_back(INPUT_INDEX);
+   worklist.push_back(INT_INDEX);
+
+   while(!worklist.empty())
+   {
+      int address = worklist.back();
+      worklist.pop_back();
+      if(address < 0 || address >= MEMORY_SIZE || visited[address])
+         continue;
+      visited[address] = true;
+
+      int opcode = image[address];
+      int length = opcode_has_operand(opcode) ? 2 : 1;
+      int next = address + length;
+      int operand = address + 1 < MEMORY_SIZE ? image[address + 1] : 0;
+      unsigned char flags = 0;
+
+      // Operand fetch stays in the region of the instruction
+      if(length == 2 && sameRegion(address, address + 1))
+         flags |= OPERAND_SAFE;
+
+      // Absolute data accesses inside the instruction's region
+      if((opcode == LOAD_ADDR || opcode == STORE) && (flags & OPERAND_SAFE) &&
+         sameRegion(address, operand))
+         flags |= TARGET_SAFE;
+
+      // Static successors
+      vector<int> successors;
+      switch(opcode)
+      {
+         case JUMP:
+	 case JUMP_RETURN:
+	    successors.push_back(operand);
+	    break;
+	 case JUMP_IF_EQ:
+	 case JUMP_IF_NEQ:
+	    successors.push_back(operand);
+	    successors.push_back(next);
+	    break;
+	 case RETURN:
+	 case SYSCALL:
+	 case SYSRETURN:
+	 case END:
+	    // Dynamic or mode-changing control flow
+	    break;
+	 default:
+	    // Invalid opcodes end the process
+	    if(opcode < LOAD_VAL || opcode > IN)
+	       break;
+	    if(length == 1 || (flags & OPERAND_SAFE))
+	       successors.push_back(next);
+	    break;
+      }
+
+      // The next fetch is proven when every static successor
+      // stays in the region of the instruction
+      bool nextSafe = !successors.empty() && (length == 1 || (flags & OPERAND_SAFE));
+      for(size_t i = 0; i < successors.size(); i++)
+      {
+         if(!sameRegion(address, successors[i]))
+	    nextSafe = false;
+	 worklist.push_back(successors[i]);
+      }
+      if(nextSafe)
+         flags |= NEXT_SAFE;
+
+      // Calls and system calls come back after the instruction
+      if(opcode == JUMP_RETURN || opcode == SYSCALL)
+         worklist.push_back(next);
+
+      site_flags[address] = flags;
+   }
+}
+
+/* Site Flags
+ * <address> instruction address
+ * <return> proven accesses of the instruction at the address
+ */
+int site_flags_at(int address)
+{
+   if(address < 0 || address >= MEMORY_SIZE)
+      return 0;
+   return site_flags[address];
+}
+
+/* Invalidate Site
+ * A store changed the word at the address, so the instruction
+ * starting there and the one whose operand it is lose their
+ * proofs.
+ *
+ * <address> address written
+ */
+void invalidate_site(int address)
+{
+   if(address >= 0 && address < MEMORY_SIZE)
+      site_flags[address] = 0;
+   if(address >= 1 && address <= MEMORY_SIZE)
+      site_flags[address - 1] = 0;
+}
+
+/* Same Region
+ * <address> first address
+ * <other> second address
+ * <return> true if both are in the same (user or kernel) region
+ */
+bool sameRegion(int address, int other)
+{
+   if(other < 0 || other >= MEMORY_SIZE)
+      return false;
+   return (address < SYS_INDEX) == (other < SYS_INDEX);
+}
@@ -0,0 +1,178 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Memory Backing
+//   Implementation below is executed by the main memory
+//   process.  Allocates large memory arrays (the VM images of
+//   the coroutine engine) on explicit huge pages, or on
+//   transparent huge pages when no huge pages are reserved,
+//   or on normal pages as a last resort.  Pages are preferably
+//   placed on the NUMA node the memory process runs on, which
+//   pinning with --pin keeps stable.
+
+#include <unistd.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "program.h"
+using namespace std;
+
+// Huge page size and the smallest array backed by huge pages
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+// NUMA memory policy (linux/mempolicy.h)
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+// Methods
+size_t backingLength(size_t bytes, int backing);
+bool   preferLocalNode(void *address, size_t length);
+
+// NUMA node of the last allocation (-1 = not bound)
+int backing_node = -1;
+
+/* Allocate Memory
+ * Allocates a zeroed array of words with the best backing
+ * available.  Arrays smaller than a huge page use normal
+ * pages.
+ *
+ * <words> number of words
+ * <backing> set to the backing used
+ * <return> the array, NULL if no memory is left
+ */
+int *allocate_memory(size_t words, int *backing)
+{
+   size_t bytes = words * sizeof(int);
+   void *address = MAP_FAILED;
+
+   if(bytes >= HUGE_PAGE_SIZE)
+   {
+      // Explicit huge pages from the reserved pool
+      *backing = BACKING_HUGETLB;
+      address = mmap(NULL, backingLength(bytes, *backing), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+      // Transparent huge pages on a huge page aligned range
+      if(address == MAP_FAILED)
+      {
+         *backing = BACKING_THP;
+	 size_t length = backingLength(bytes, *backing);
+	 char *range = (char *)mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+	                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	 if(range != MAP_FAILED)
+	 {
+	    // Trim the range to the aligned part
+	    char *aligned = (char *)(((uintptr_t)range + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+	    if(aligned > range)
+	       munmap(range, aligned - range);
+	    munmap(aligned + length, range + HUGE_PAGE_SIZE - aligned);
+	    if(madvise(aligned, length, MADV_HUGEPAGE) == 0)
+	       address = aligned;
+	    else
+	       munmap(aligned, length);
+	 }
+      }
+   }
+
+   // Normal pages
+   if(address == MAP_FAILED)
+   {
+      *backing = BACKING_PAGES;
+      address = mmap(NULL, backingLength(bytes, *backing), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(address == MAP_FAILED)
+         return NULL;
+   }
+
+   // Place the pages before they are first touched
+   preferLocalNode(address, backingLength(bytes, *backing));
+   return (int *)address;
+}
+
+/* Release Memory
+ * <memory> array from allocate_memory
+ * <words> number of words
+ * <backing> backing of the array
+ */
+void release_memory(int *memory, size_t words, int backing)
+{
+   if(memory != NULL)
+      munmap(memory, backingLength(words * sizeof(int), backing));
+}
+
+/* Backing Name
+ * <backing> backing of an array
+ * <return> printable name of the backing
+ */
+const char *backing_name(int backing)
+{
+   switch(backing)
+   {
+      case BACKING_HUGETLB: return "explicit huge pages";
+      case BACKING_THP: return "transparent huge pages";
+      default: return "normal pages";
+   }
+}
+
+/* Backing Node
+ * <return> NUMA node of the last allocation, -1 if unbound
+ */
+int backing_numa_node()
+{
+   return backing_node;
+}
+
+/* Backing Length
+ * <bytes> array size
+ * <backing> backing of the array
+ * <return> mapping length, rounded to the page size used
+ */
+size_t backingLength(size_t bytes, int backing)
+{
+   size_t page = backing == BACKING_PAGES ? (size_t)sysconf(_SC_PAGESIZE) : HUGE_PAGE_SIZE;
+   return (bytes + page - 1) / page * page;
+}
+
+/* Prefer Local Node
+ * Asks the kernel to place the pages on the NUMA node of
+ * the CPU running the memory process.  Only a preference,
+ * so allocation still succeeds when the node is full.
+ *
+ * <address> start of the mapping
+ * <length> mapping length
+ * <return> false if the preference could not be set
+ */
+bool preferLocalNode(void *address, size_t length)
+{
+   unsigned int cpu, node;
+   if(getcpu(&cpu, &node) != 0 || node >= 8 * sizeof(unsigned long))
+      return false;
+
+   unsigned long mask = 1UL << node;
+   if(syscall(SYS_mbind, address, length, MPOL_PREFERRED, &mask,
+              8 * sizeof(unsigned long), 0) != 0)
+      return false;
+
+   backing_node = node;
+   return true;
+}
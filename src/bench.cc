@@ -0,0 +1,386 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Opcode Benchmark
+//   Implementation below is executed by the --bench mode.
+//   Generates a kernel per opcode, runs it with this
+//   executable under every engine and memory transport, and
+//   prints the host nanoseconds per instruction as a matrix.
+//   Each kernel is a loop around a body of copies of one
+//   instruction; the same loop with an empty body is timed
+//   as well and subtracted, which removes process startup,
+//   loading, the kernel setup and the loop control.
+//   Instructions that need another one to run repeatedly (a
+//   Call needs its Ret) have the cost of that helper
+//   subtracted as well.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "program.h"
+using namespace std;
+
+// Kernel layout: code from 0, loop counter and data words
+// above the code, stacks well clear of both
+#define BENCH_COUNTER 700
+#define BENCH_DATA 701
+#define BENCH_POINTER 702
+#define BENCH_STORE 703
+#define BENCH_SUBROUTINE 710
+#define BENCH_STACK 990
+#define BENCH_POP_STACK 760
+#define BENCH_CODE_WORDS 640
+
+// Placeholders in kernel units for addresses known only
+// when the kernel is laid out
+#define UNIT_NEXT -1
+#define UNIT_SUBROUTINE -2
+
+// Timer that never fires, runs per measurement, and the
+// longest a run may take (s)
+#define BENCH_TIMER "1000000000"
+#define BENCH_REPEATS 3
+#define BENCH_TIMEOUT 30
+
+// Kernel for one opcode: setup run at the top of every
+// iteration, the repeated unit, the other opcodes a unit
+// executes whose cost is subtracted, and the most copies
+// the stack leaves room for (0 = no limit)
+struct bench_kernel
+{
+   int opcode;
+   vector<int> setup;
+   vector<int> unit;
+   vector<int> helpers;
+   int maxCopies;
+};
+
+// Engine or transport to measure, as run options
+struct bench_engine
+{
+   const char *name;
+   vector<const char *> options;
+};
+
+// Kernel shape: body copies and loop iterations
+struct bench_shape
+{
+   const char *name;
+   int copies;
+   int iterations;
+};
+
+// Methods
+vector<bench_kernel> benchKernels();
+vector<bench_engine> benchEngines();
+string writeKernel(const string &directory, const bench_kernel &kernel, int copies, int iterations);
+double timeRun(const string &executable, const string &file, const bench_engine &engine);
+double bestTime(const string &executable, const string &file, const bench_engine &engine);
+
+/* Run Benchmark
+ * Measures every opcode on the engines named on the command
+ * line (all of them by default) and prints one matrix per
+ * kernel shape.
+ *
+ * <argc> arg count
+ * <argv> command-line arguments, engine names from argv[2]
+ * <return> SUCCESS, or CLI_FAILURE for an unknown engine
+ */
+int run_benchmark(int argc, char *argv[])
+{
+   vector<bench_engine> engines = benchEngines();
+   if(argc > 2)
+   {
+      vector<bench_engine> chosen;
+      for(int i = 2; i < argc; i++)
+      {
+         size_t e = 0;
+	 while(e < engines.size() && string(engines[e].name) != argv[i])
+	    e++;
+	 if(e == engines.size())
+	 {
+	    cout << "ERROR: Unknown engine " << argv[i] << ". Engines:";
+	    for(size_t k = 0; k < engines.size(); k++)
+	       cout << " " << engines[k].name;
+	    cout << endl;
+	    return CLI_FAILURE;
+	 }
+	 chosen.push_back(engines[e]);
+      }
+      engines = chosen;
+   }
+
+   char path[4096];
+   ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+   char directory[] = "/tmp/simos-bench-XXXXXX";
+   if(length <= 0 || mkdtemp(directory) == NULL)
+   {
+      cout << "ERROR: Cannot set up the benchmark" << endl;
+      return PROGRAM_PATH_FAILURE;
+   }
+   path[length] = '\0';
+   string executable = path;
+
+   vector<bench_kernel> kernels = benchKernels();
+   bench_shape shapes[2] = { { "STRAIGHT-LINE", 0, 1 }, { "LOOPED", 16, 256 } };
+   for(int s = 0; s < 2; s++)
+   {
+      bench_shape shape = shapes[s];
+      cout << shape.name << " KERNELS (host ns per instruction)" << endl;
+      cout << setw(16) << "opcode";
+      for(size_t e = 0; e < engines.size(); e++)
+         cout << setw(17) << engines[e].name;
+      cout << endl;
+
+      // Costs per engine, filled in kernel order so helpers
+      // are known before the kernels using them.  Empty body
+      // times are shared by kernels with the same setup.
+      vector<map<int, double> > costs(engines.size());
+      map<vector<int>, vector<double> > baselines;
+
+      for(size_t k = 0; k < kernels.size(); k++)
+      {
+         const bench_kernel &kernel = kernels[k];
+	 if(baselines.count(kernel.setup) == 0)
+	 {
+	    vector<double> &baseline = baselines[kernel.setup];
+	    string emptyFile = writeKernel(directory, kernel, 0, shape.iterations);
+	    for(size_t e = 0; e < engines.size(); e++)
+	       baseline.push_back(bestTime(executable, emptyFile, engines[e]));
+	    unlink(emptyFile.c_str());
+	 }
+	 const vector<double> &baseline = baselines[kernel.setup];
+
+	 // Straight-line kernels fill the code area in one pass
+	 int copies = shape.copies;
+	 if(copies == 0)
+	    copies = (BENCH_CODE_WORDS - 32) / kernel.unit.size();
+	 if(kernel.maxCopies > 0)
+	    copies = min(copies, kernel.maxCopies);
+	 string file = writeKernel(directory, kernel, copies, shape.iterations);
+
+         cout << setw(16) << opcode_name(kernel.opcode);
+	 for(size_t e = 0; e < engines.size(); e++)
+	 {
+	    double elapsed = bestTime(executable, file, engines[e]);
+	    bool known = elapsed >= 0 && baseline[e] >= 0;
+	    double cost = 0;
+	    if(known)
+	    {
+	       cost = (elapsed - baseline[e]) / ((double)copies * shape.iterations);
+	       for(size_t h = 0; h < kernel.helpers.size(); h++)
+	       {
+	          if(costs[e].count(kernel.helpers[h]) == 0)
+		     known = false;
+		  else
+		     cost -= costs[e][kernel.helpers[h]];
+	       }
+	    }
+	    if(known)
+	    {
+	       costs[e][kernel.opcode] = cost;
+	       cout << setw(17) << fixed << setprecision(0) << cost;
+	    }
+	    else
+	       cout << setw(17) << "-";
+	 }
+	 cout << endl;
+	 unlink(file.c_str());
+      }
+      cout << endl;
+   }
+
+   rmdir(directory);
+   cout << "Int includes its IRet.  \"-\": the engine does not" << endl;
+   cout << "support the opcode, or a kernel it depends on failed." << endl;
+   return SUCCESS;
+}
+
+/* Bench Kernels
+ * <return> kernels for every opcode but END, helpers first
+ */
+vector<bench_kernel> benchKernels()
+{
+   // Pushes stay above the subroutine, pops below SYS_INDEX
+   int pushRoom = BENCH_STACK - BENCH_SUBROUTINE - 16;
+   int popRoom = SYS_INDEX - BENCH_POP_STACK;
+
+   return {
+      { LOAD_VAL, {}, { LOAD_VAL, 5 }, {}, 0 },
+      { LOAD_ADDR, {}, { LOAD_ADDR, BENCH_DATA }, {}, 0 },
+      { LOAD_IND_ADDR, {}, { LOAD_IND_ADDR, BENCH_POINTER }, {}, 0 },
+      { LOAD_IDX_X_ADDR, { LOAD_VAL, 0, COPY_TO_X }, { LOAD_IDX_X_ADDR, BENCH_DATA }, {}, 0 },
+      { LOAD_IDX_Y_ADDR, { LOAD_VAL, 0, COPY_TO_Y }, { LOAD_IDX_Y_ADDR, BENCH_DATA }, {}, 0 },
+      { LOAD_SPX, { LOAD_VAL, BENCH_STACK, COPY_TO_SP, LOAD_VAL, 0, COPY_TO_X }, { LOAD_SPX }, {}, 0 },
+      { STORE, {}, { STORE, BENCH_STORE }, {}, 0 },
+      { GET, {}, { GET }, {}, 0 },
+      { PUT, {}, { PUT, 1 }, {}, 0 },
+      { ADDX, {}, { ADDX }, {}, 0 },
+      { ADDY, {}, { ADDY }, {}, 0 },
+      { SUBX, {}, { SUBX }, {}, 0 },
+      { SUBY, {}, { SUBY }, {}, 0 },
+      { COPY_TO_X, {}, { COPY_TO_X }, {}, 0 },
+      { COPY_FR_X, {}, { COPY_FR_X }, {}, 0 },
+      { COPY_TO_Y, {}, { COPY_TO_Y }, {}, 0 },
+      { COPY_FR_Y, {}, { COPY_FR_Y }, {}, 0 },
+      { COPY_TO_SP, { COPY_FR_SP }, { COPY_TO_SP }, {}, 0 },
+      { COPY_FR_SP, {}, { COPY_FR_SP }, {}, 0 },
+      { JUMP, {}, { JUMP, UNIT_NEXT }, {}, 0 },
+      { JUMP_IF_EQ, { LOAD_VAL, 0 }, { JUMP_IF_EQ, UNIT_NEXT }, {}, 0 },
+      { JUMP_IF_NEQ, { LOAD_VAL, 1 }, { JUMP_IF_NEQ, UNIT_NEXT }, {}, 0 },
+      { INCX, {}, { INCX }, {}, 0 },
+      { DECX, {}, { DECX }, {}, 0 },
+      { PUSH, { LOAD_VAL, BENCH_STACK, COPY_TO_SP }, { PUSH }, {}, pushRoom },
+      { POP, { LOAD_VAL, BENCH_POP_STACK, COPY_TO_SP }, { POP }, {}, popRoom },
+      { RETURN, { LOAD_VAL, BENCH_STACK, COPY_TO_SP }, { LOAD_VAL, UNIT_NEXT, PUSH, RETURN }, { LOAD_VAL, PUSH }, 0 },
+      { JUMP_RETURN, { LOAD_VAL, BENCH_STACK, COPY_TO_SP }, { JUMP_RETURN, UNIT_SUBROUTINE }, { RETURN }, 0 },
+      { SYSCALL, {}, { SYSCALL }, {}, 0 },
+      { IN, {}, { IN, RNG_BASE - IO_BASE }, {}, 0 },
+   };
+}
+
+/* Bench Engines
+ * <return> engines and memory transports to measure
+ */
+vector<bench_engine> benchEngines()
+{
+   return {
+      { "signal", {} },
+      { "busy-poll", { "--busy-poll" } },
+      { "decoupled-fetch", { "--decoupled-fetch" } },
+      { "elide-checks", { "--elide-checks" } },
+      { "fast-forward", { "--fast-forward" } },
+      { "coroutine", { "--vms", "1" } },
+   };
+}
+
+/* Write Kernel
+ * Lays out a kernel program:
+ *
+ *   head:  setup
+ *          unit x copies
+ *          counter = counter - 1, loop to head while not 0
+ *          End
+ *   710:   Ret (subroutine for Call)
+ *   1000:  IRet, 1500: IRet (interrupt handlers)
+ *
+ * <directory> directory for the program file
+ * <kernel> kernel to lay out
+ * <copies> copies of the unit in the body
+ * <iterations> loop iterations
+ * <return> path of the program file
+ */
+string writeKernel(const string &directory, const bench_kernel &kernel, int copies, int iterations)
+{
+   vector<int> code(kernel.setup);
+   for(int c = 0; c < copies; c++)
+   {
+      int start = code.size();
+      for(size_t i = 0; i < kernel.unit.size(); i++)
+      {
+         int word = kernel.unit[i];
+	 if(word == UNIT_NEXT)
+	    word = start + kernel.unit.size();
+	 else if(word == UNIT_SUBROUTINE)
+	    word = BENCH_SUBROUTINE;
+	 code.push_back(word);
+      }
+   }
+   vector<int> tail = { LOAD_VAL, 1, COPY_TO_Y, LOAD_ADDR, BENCH_COUNTER, SUBY,
+                        STORE, BENCH_COUNTER, JUMP_IF_NEQ, 0, END };
+   code.insert(code.end(), tail.begin(), tail.end());
+
+   stringstream name;
+   name << directory << "/" << opcode_name(kernel.opcode) << "-" << copies << "x" << iterations << ".txt";
+   ofstream file(name.str().c_str());
+   for(size_t i = 0; i < code.size(); i++)
+      file << code[i] << endl;
+   file << "." << BENCH_COUNTER << endl << iterations << endl << 5 << endl << BENCH_DATA << endl;
+   file << "." << BENCH_SUBROUTINE << endl << RETURN << endl;
+   file << "." << SYS_INDEX << endl << SYSRETURN << endl;
+   file << "." << INT_INDEX << endl << SYSRETURN << endl;
+   return name.str();
+}
+
+/* Best Time
+ * <executable> simulator executable
+ * <file> kernel program
+ * <engine> engine options
+ * <return> fastest of the repeated runs (ns), -1 on failure
+ */
+double bestTime(const string &executable, const string &file, const bench_engine &engine)
+{
+   double best = -1;
+   for(int r = 0; r < BENCH_REPEATS; r++)
+   {
+      double elapsed = timeRun(executable, file, engine);
+      if(elapsed < 0)
+         return -1;
+      if(best < 0 || elapsed < best)
+         best = elapsed;
+   }
+   return best;
+}
+
+/* Time Run
+ * Runs a kernel in a child simulator with its output
+ * discarded.
+ *
+ * <executable> simulator executable
+ * <file> kernel program
+ * <engine> engine options
+ * <return> wall time (ns), -1 if the run failed
+ */
+double timeRun(const string &executable, const string &file, const bench_engine &engine)
+{
+   vector<const char *> args = { executable.c_str(), file.c_str(), BENCH_TIMER };
+   args.insert(args.end(), engine.options.begin(), engine.options.end());
+   args.push_back(NULL);
+
+   long long start = monotonic_nanos();
+   int pid = fork();
+   if(pid == 0)
+   {
+      int null = open("/dev/null", O_WRONLY);
+      dup2(null, STDOUT_FILENO);
+      dup2(null, STDERR_FILENO);
+      alarm(BENCH_TIMEOUT);
+      execv(args[0], (char *const *)&args[0]);
+      _exit(PROGRAM_PATH_FAILURE);
+   }
+   int status = -1;
+   if(pid < 0 || waitpid(pid, &status, 0) != pid)
+      return -1;
+   long long end = monotonic_nanos();
+
+   if(!WIFEXITED(status) || WEXITSTATUS(status) != SUCCESS)
+      return -1;
+   return end - start;
+}
@@ -0,0 +1,203 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Device Bus
+//   Implementation below is executed by the processor process.
+//   Devices register an address range in the I/O region above
+//   main memory and the bus routes reads and writes in that
+//   range to the device callbacks through a page-granular
+//   dispatch table.  The built-in console, RNG, timer, disk and
+//   framebuffer are the libsimos devices (devices.cc,
+//   framebuffer.cc), one of each for the process.
+
+#include <iostream>
+#include "program.h"
+using namespace std;
+
+// Processor state exposed through the timer device
+extern int interrupt_timer;
+extern int instruction_counter;
+
+// Console input from the input port
+class port_input : public simos::console_input<int>
+{
+public:
+   int  read_int() { return input_port_read_int(); }
+   int  read_char() { return input_port_read_char(); }
+   int  status() { return input_port_status(); }
+   void arm_interrupt() { arm_input_interrupt(); }
+};
+
+// Methods
+bool consoleRead(int offset, int *value);
+bool consoleWrite(int offset, int value);
+bool rngRead(int offset, int *value);
+bool rngWrite(int offset, int value);
+bool timerRead(int offset, int *value);
+bool timerWrite(int offset, int value);
+bool diskRead(int offset, int *value);
+bool diskWrite(int offset, int value);
+bool framebufferRead(int offset, int *value);
+bool framebufferWrite(int offset, int value);
+bool cellsRead(int offset, int *value);
+bool cellsWrite(int offset, int value);
+
+// Registered devices and the page dispatch table.  A NULL
+// entry means no device is mapped on that page.
+device devices[MAX_DEVICES];
+int device_count = 0;
+device *device_table[IO_SIZE >> IO_PAGE_SHIFT];
+
+// Built-in devices of the process
+port_input console_port;
+simos::console_device<int> builtin_console(&console_port, &cout);
+simos::rng_device<int> builtin_rng;
+simos::timer_device<int> builtin_timer(interrupt_timer, [] { return (long long)instruction_counter; });
+simos::disk_device<int> builtin_disk;
+simos::framebuffer_device<int> builtin_framebuffer(builtin_console);
+
+/* Register Device
+ * Map a device into the I/O region.  The range must be page
+ * aligned, inside the I/O region and not overlap any device
+ * already registered.
+ *
+ * <dev> device description and callbacks
+ * <return> false if the device could not be mapped
+ */
+bool register_device(const device &dev)
+{
+   int first = dev.base - IO_BASE;
+   int last = first + dev.size - 1;
+
+   // Check capacity, alignment and bounds
+   if(device_count == MAX_DEVICES || dev.size <= 0 ||
+      first < 0 || last >= IO_SIZE ||
+      (first & IO_PAGE_MASK) != 0)
+      return false;
+
+   // Check for overlap with existing devices
+   for(int page = first >> IO_PAGE_SHIFT; page <= last >> IO_PAGE_SHIFT; page++)
+      if(device_table[page] != NULL)
+         return false;
+
+   devices[device_count] = dev;
+   for(int page = first >> IO_PAGE_SHIFT; page <= last >> IO_PAGE_SHIFT; page++)
+      device_table[page] = &devices[device_count];
+   device_count++;
+   return true;
+}
+
+/* Find Device
+ * Look up the device mapped at an address.  Addresses
+ * outside the I/O region fail the first compare, so
+ * ordinary memory accesses only pay a single branch.
+ *
+ * <address> address being accessed
+ * <return> device mapped at the address or NULL
+ */
+device *find_device(int address)
+{
+   unsigned int offset = address - IO_BASE;
+   if(offset >= IO_SIZE)
+      return NULL;
+
+   device *dev = device_table[offset >> IO_PAGE_SHIFT];
+   if(dev == NULL || address >= dev->base + dev->size)
+      return NULL;
+   return dev;
+}
+
+/* Kernel Register
+ * <dev> device mapped at the address
+ * <address> address being accessed
+ * <return> true if only kernel mode may access the register
+ */
+bool kernel_register(const device &dev, int address)
+{
+   int offset = address - dev.base;
+   return offset < 32 && (dev.kernel_registers >> offset) & 1;
+}
+
+/* Register Builtin Devices
+ * Map the console, RNG, timer, disk and framebuffer devices.
+ */
+void register_builtin_devices()
+{
+   register_device({"console", CONSOLE_BASE, IO_PAGE_SIZE, consoleRead, consoleWrite});
+   register_device({"rng", RNG_BASE, IO_PAGE_SIZE, rngRead, rngWrite});
+   register_device({"timer", TIMER_BASE, IO_PAGE_SIZE, timerRead, timerWrite,
+                    TIMER_KERNEL_REGISTERS});
+   register_device({"disk", DISK_BASE, IO_PAGE_SIZE, diskRead, diskWrite});
+   register_device({"framebuffer", FB_BASE, IO_PAGE_SIZE, framebufferRead, framebufferWrite});
+   register_device({"fb-cells", FB_CELLS, FB_WIDTH * FB_HEIGHT, cellsRead, cellsWrite});
+}
+
+/* Start Disk
+ * Open the host file backing the disk device.  Without a
+ * path the disk is empty.
+ *
+ * <path> host file path or NULL
+ * <return> false if the file could not be opened
+ */
+bool start_disk(const char *path)
+{
+   return builtin_disk.open(path);
+}
+
+/* Set Framebuffer Refresh
+ * <interval> instructions between renders, 0 for on demand only
+ */
+void set_framebuffer_refresh(int interval)
+{
+   builtin_framebuffer.set_refresh(interval);
+}
+
+/* Tick Framebuffer
+ * Called by the execution cycle after every instruction.
+ *
+ * <count> instruction counter
+ */
+void tick_framebuffer(int count)
+{
+   builtin_framebuffer.tick(count);
+}
+
+/* Render Framebuffer
+ * Draws the dirty rows of the framebuffer.
+ */
+void render_framebuffer()
+{
+   builtin_framebuffer.render();
+}
+
+// Device callbacks of the bus
+bool consoleRead(int offset, int *value) { return builtin_console.read(offset, value); }
+bool consoleWrite(int offset, int value) { return builtin_console.write(offset, value); }
+bool rngRead(int offset, int *value) { return builtin_rng.read(offset, value); }
+bool rngWrite(int offset, int value) { return builtin_rng.write(offset, value); }
+bool timerRead(int offset, int *value) { return builtin_timer.read(offset, value); }
+bool timerWrite(int offset, int value) { return builtin_timer.write(offset, value); }
+bool diskRead(int offset, int *value) { return builtin_disk.read(offset, value); }
+bool diskWrite(int offset, int value) { return builtin_disk.write(offset, value); }
+bool framebufferRead(int offset, int *value) { return builtin_framebuffer.read(offset, value); }
+bool framebufferWrite(int offset, int value) { return builtin_framebuffer.write(offset, value); }
+bool cellsRead(int offset, int *value) { return builtin_framebuffer.cells_read(offset, value); }
+bool cellsWrite(int offset, int value) { return builtin_framebuffer.cells_write(offset, value); }
@@ -0,0 +1,89 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Checkpoint
+//   Implementation below is executed by the processor process.
+//   With --checkpoint, the final machine state is written to a
+//   text file when the processor ends: timer, counters, flags,
+//   registers, the memory digest and the memory image.  The
+//   digest line alone tells whether two checkpoints hold the
+//   same memory.
+
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include "program.h"
+using namespace std;
+
+// Checkpoint format version
+#define CHECKPOINT_VERSION 1
+
+// Processor state
+extern int registers[REGCOUNT];
+extern int interrupt_timer;
+extern int instruction_counter;
+extern int inactive_sys_stack, inactive_proc_stack;
+extern bool interruptEnabledFlag;
+extern bool kernelMode;
+
+// Checkpoint file path (NULL = none)
+const char *checkpoint_file = NULL;
+
+/* Set Checkpoint File
+ * <path> file to write the final state to, or NULL
+ */
+void set_checkpoint_file(const char *path)
+{
+   checkpoint_file = path;
+}
+
+/* Write Checkpoint
+ * Writes the machine state to the checkpoint file.  Called
+ * while main memory is still running.
+ *
+ * <exitCode> exit status of the run
+ */
+void write_checkpoint(int exitCode)
+{
+   if(checkpoint_file == NULL)
+      return;
+
+   vector<int> image(MEMORY_SIZE);
+   uint64_t digest = memory_digest();
+   if(!dump_memory(&image[0]))
+      return;
+
+   ofstream file(checkpoint_file);
+   file << "checkpoint " << CHECKPOINT_VERSION << endl;
+   file << "exit " << exitCode << endl;
+   file << "timer " << interrupt_timer << endl;
+   file << "instructions " << instruction_counter << endl;
+   file << "mode " << kernelMode << " " << interruptEnabledFlag << endl;
+   file << "registers";
+   for(int i = 0; i < REGCOUNT; i++)
+      file << " " << registers[i];
+   file << endl;
+   file << "stacks " << inactive_sys_stack << " " << inactive_proc_stack << endl;
+   file << "digest " << hex << setfill('0') << setw(16) << digest << dec << endl;
+   file << "memory " << MEMORY_SIZE << endl;
+   for(int i = 0; i < MEMORY_SIZE; i++)
+      file << image[i] << endl;
+}
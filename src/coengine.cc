@@ -0,0 +1,556 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Coroutine Engine
+//   Implementation below is executed by the processor process.
+//   Runs many copies (VMs) of the program at once.  The
+//   execution cycle of each VM is a coroutine which suspends
+//   on every main memory access, running the instructions on
+//   the execute core shared with the processor: an instruction
+//   that has to wait for main memory is run again from its
+//   start once the reply arrives, with the results of the
+//   accesses it already made replayed.  Once every VM is waiting,
+//   their requests go to the main memory process as a single
+//   batch, so one pipe round trip serves all the VMs instead
+//   of one instruction.  Each VM has its own image in main
+//   memory, its own registers, timer and random number seed,
+//   and its console output is buffered and printed when it
+//   ends.  Only the console output and RNG devices exist.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <coroutine>
+#include <exception>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include "program.h"
+#include "execute.h"
+#include "tracepoints.h"
+using namespace std;
+
+// Ends a VM with its exit code
+struct vm_exit
+{
+   int code;
+};
+
+// Registers and flags of a VM, saved at the start of each
+// instruction so that it can run again after a wait
+struct vm_state
+{
+   int registers[REGCOUNT];
+   int inactive_sys_stack, inactive_proc_stack;
+   bool interruptEnabledFlag;
+   bool kernelMode;
+};
+
+// State of one VM
+struct vm_context
+{
+   int index;
+   vm_state state;
+   int interrupt_timer;
+   int instruction_counter;
+   unsigned int seed;
+   string output;
+   int exitCode;
+
+   // Results of the accesses made so far by the instruction
+   // being run
+   vector<int> served;
+
+   // Outstanding memory request and the point to resume at
+   // once its reply arrives
+   mem_request request;
+   int status;
+   int result;
+   coroutine_handle<> waiting;
+};
+
+// Coroutine running the execution cycle of a VM
+struct vm_task
+{
+   struct promise_type
+   {
+      vm_task get_return_object()
+      {
+         return vm_task{coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      suspend_always initial_suspend() noexcept { return {}; }
+      suspend_always final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { terminate(); }
+   };
+
+   coroutine_handle<promise_type> handle;
+};
+
+// Main memory access of a VM, suspending it until the batch
+// with its request has been served
+struct memory_access
+{
+   vm_context &vm;
+
+   bool await_ready() { return false; }
+   void await_suspend(coroutine_handle<> handle);
+   int  await_resume();
+};
+
+// Execute core policy of a VM.  Device accesses complete at
+// once.  A main memory access that has not been served yet
+// queues its request and blocks the instruction: the rest of
+// it does nothing, and run_vm runs it again once the reply
+// has arrived.  Accesses already served are replayed from the
+// VM instead of being made again.
+struct vm_cpu
+{
+   typedef int word;
+   vm_context &vm;
+   int *registers;
+   size_t replayed;
+   bool blocked;
+   int handler;   // vector of a SYSCALL, -1 = none
+   int returned;  // PC returned to by SYSRETURN, -1 = none
+
+   int  access(int action, int address, int value);
+   int  fetch_operand()
+   {
+      int address = registers[PC];
+      registers[PC] = wrapping_add(address, 1);
+      return read(address);
+   }
+   int  fetch_target() { return read(registers[PC]); }
+   int  read(int address) { return access(READ, address, 0); }
+   void write(int address, int value) { access(WRITE, address, value); }
+   int  read_target(int address) { return read(address); }
+   void write_target(int address, int value) { write(address, value); }
+   int  read_port(int port);
+   void write_port(int port, int value);
+   void syscall(int address) { handler = address; }
+   void return_syscall();
+   void end(int exitCode);
+};
+
+// Methods
+vm_task run_vm(vm_context &vm);
+bool deviceAccess(vm_context &vm, int action, int address, int *value);
+void verifyVMAccess(vm_context &vm, int address);
+void serveBatch(vector<vm_context *> &batch);
+void endEngine(int exitCode);
+bool readReply(void *buffer, size_t size);
+
+// Requests waiting for the next batch
+vector<vm_context *> pending;
+
+// Process Ids and pipes to Main Memory
+int *engine_process;
+int *engine_writeToMem;
+int *engine_readFromMem;
+
+// Batches sent and requests served
+long long batch_count = 0;
+long long request_count = 0;
+
+/* Run Coroutine Engine
+ * Clones the loaded program once per VM in main memory,
+ * then resumes every runnable VM until it waits on memory
+ * and serves the waiting requests as one batch, until
+ * every VM has ended.  Prints the output and exit code of
+ * each VM in order and exits with the first failure.
+ *
+ * <timer> instruction count till timeout
+ * <vmCount> number of VMs to run
+ * <pid> process id array
+ * <wToMem> write pipe to main memory
+ * <rFromMem> read pipe from main memory
+ */
+void run_coroutine_engine(int timer, int vmCount, int *pid, int wToMem[], int rFromMem[])
+{
+   engine_process = pid;
+   engine_writeToMem = wToMem;
+   engine_readFromMem = rFromMem;
+
+   // One image per VM, and where main memory placed them
+   int action = CLONE;
+   int status = READ_FAILURE;
+   int placement[2];
+   write(engine_writeToMem[1], &action, sizeof(int));
+   write(engine_writeToMem[1], &vmCount, sizeof(int));
+   notify_memory(engine_process[MAIN_MEMORY]);
+   if(!readReply(&status, sizeof(int)) || status != SUCCESS ||
+      !readReply(placement, sizeof(placement)))
+      endEngine(status);
+
+   // Initialize the VMs as run_processor does
+   vector<vm_context> vms(vmCount);
+   vector<vm_task> tasks;
+   for(int i = 0; i < vmCount; i++)
+   {
+      vm_context &vm = vms[i];
+      vm.index = i;
+      for(int r = 0; r < REGCOUNT; r++)
+         vm.state.registers[r] = 0;
+      vm.interrupt_timer = timer;
+      vm.instruction_counter = 0;
+      vm.state.inactive_sys_stack = MEMORY_SIZE;
+      vm.state.registers[SP] = vm.state.inactive_proc_stack = SYS_INDEX;
+      vm.state.interruptEnabledFlag = true;
+      vm.state.kernelMode = false;
+      vm.seed = i + 1;
+      vm.exitCode = PROGRAM_PATH_FAILURE;
+
+      tasks.push_back(run_vm(vm));
+      vm.waiting = tasks.back().handle;
+   }
+
+   // Resume the runnable VMs, then serve their requests
+   vector<vm_context *> runnable;
+   for(int i = 0; i < vmCount; i++)
+      runnable.push_back(&vms[i]);
+   pending.reserve(vmCount);
+
+   while(!runnable.empty())
+   {
+      for(size_t i = 0; i < runnable.size(); i++)
+         runnable[i]->waiting.resume();
+
+      runnable.swap(pending);
+      pending.clear();
+      if(!runnable.empty())
+         serveBatch(runnable);
+   }
+
+   for(size_t i = 0; i < tasks.size(); i++)
+      tasks[i].handle.destroy();
+
+   // Report every VM in order
+   int exitCode = SUCCESS;
+   for(int i = 0; i < vmCount; i++)
+   {
+      if(vmCount > 1)
+         cout << "VM " << i << ":" << endl;
+      cout << vms[i].output;
+      cout << "EXIT CODE: " << exit_code_name(vms[i].exitCode) << endl << endl;
+      if(exitCode == SUCCESS)
+         exitCode = vms[i].exitCode;
+   }
+   cerr << vmCount << " VMs, " << request_count << " memory requests in "
+        << batch_count << " batches, images on " << backing_name(placement[0]);
+   if(placement[1] >= 0)
+      cerr << " (NUMA node " << placement[1] << ")";
+   cerr << endl;
+
+   // Pages shared with the loaded program and private copies
+   long long footprint[2];
+   int header[2] = { FOOTPRINT, 0 };
+   write(engine_writeToMem[1], header, sizeof(header));
+   notify_memory(engine_process[MAIN_MEMORY]);
+   if(readReply(footprint, sizeof(footprint)))
+      cerr << "Image bytes: " << footprint[0] << " shared, " << footprint[1]
+           << " private (" << footprint[1] / vmCount << " per VM, "
+	   << (long long)MEMORY_SIZE * sizeof(int) << " for a full copy)" << endl;
+
+   kill(engine_process[MAIN_MEMORY], SIGKILL);
+   exit(exitCode);
+}
+
+/* Run VM
+ * Execution cycle of one VM, following run_execution_cycle
+ * of the processor: fetch, execute, count, and check for the
+ * timer interrupt.  Mode switches of SYSCALL and the timer
+ * are done after the instruction, since both push the
+ * registers through main memory.  An instruction blocked on
+ * main memory is undone, and run again after the wait.
+ *
+ * <vm> VM to run
+ */
+vm_task run_vm(vm_context &vm)
+{
+   int *registers = vm.state.registers;
+
+   try{
+      while(true)
+      {
+         vm_state saved = vm.state;
+	 vm_cpu cpu = { vm, registers, 0, false, -1, -1 };
+	 int address = registers[PC];
+
+         // Fetch, decode and execute
+         registers[IR] = cpu.fetch_operand();
+	 execute_instruction(cpu);
+
+	 // Timer interrupt, unless a system call is being entered
+	 int handler = cpu.handler;
+	 if(handler == -1 && (vm.instruction_counter + 1) % vm.interrupt_timer == 0)
+	    handler = SYS_INDEX;
+
+	 // Mode switch into the interrupt handler
+	 int interrupted = -1;
+	 if(handler != -1 && vm.state.interruptEnabledFlag && !vm.state.kernelMode)
+	 {
+	    vm.state.kernelMode = true;
+	    vm.state.interruptEnabledFlag = false;
+	    vm.state.inactive_proc_stack = registers[SP];
+	    registers[SP] = vm.state.inactive_sys_stack;
+	    push_registers(cpu);
+	    interrupted = registers[PC];
+	    registers[PC] = handler;
+	 }
+
+	 // Wait for main memory, then run the instruction again
+	 if(cpu.blocked)
+	 {
+	    vm.state = saved;
+	    vm.served.push_back(co_await memory_access{vm});
+	    continue;
+	 }
+	 vm.served.clear();
+
+	 vm.instruction_counter++;
+	 if(cpu.returned != -1)
+	    TRACE_PROBE1(interrupt_exit, cpu.returned);
+	 TRACE_PROBE2(instruction_retire, address, registers[IR]);
+	 if(interrupted != -1)
+	    TRACE_PROBE2(interrupt_entry, handler, interrupted);
+      }
+   }catch(vm_exit &end){
+      vm.exitCode = end.code;
+   }
+}
+
+/* Access
+ * Devices are handled at once.  Main memory accesses are
+ * verified like verifyAccess does and queued for the next
+ * batch, blocking the instruction.
+ *
+ * <action> READ or WRITE
+ * <address> address accessed
+ * <value> value to write
+ * <return> value read, 0 once blocked
+ */
+int vm_cpu::access(int action, int address, int value)
+{
+   if(blocked)
+      return 0;
+   if(replayed < vm.served.size())
+      return vm.served[replayed++];
+
+   if(!deviceAccess(vm, action, address, &value))
+   {
+      verifyVMAccess(vm, address);
+      vm.request.action = action;
+      vm.request.vm = vm.index;
+      vm.request.address = address;
+      vm.request.value = value;
+      blocked = true;
+      return 0;
+   }
+
+   vm.served.push_back(value);
+   replayed++;
+   return value;
+}
+
+/* Read Port
+ * No input port in the coroutine engine.
+ *
+ * <port> port value
+ * <return> never returns a value unless blocked
+ */
+int vm_cpu::read_port(int port)
+{
+   end(INVALID_PORT_CALL);
+   return 0;
+}
+
+/* Write Port
+ * <port> offset into the I/O region
+ * <value> value to write
+ */
+void vm_cpu::write_port(int port, int value)
+{
+   if(port < 0)
+      end(INVALID_PORT_CALL);
+   write(wrapping_add(port, IO_BASE), value);
+}
+
+/* Return Syscall
+ * Pop registers, switch stacks and return to user mode.
+ */
+void vm_cpu::return_syscall()
+{
+   pop_registers(*this);
+   vm.state.inactive_sys_stack = registers[SP];
+   registers[SP] = vm.state.inactive_proc_stack;
+   vm.state.interruptEnabledFlag = true;
+   vm.state.kernelMode = false;
+   returned = registers[PC];
+}
+
+/* End
+ * Ends the VM, unless the instruction is blocked and so
+ * decoded or checked values it has not read yet.
+ *
+ * <exitCode> Exit status value
+ */
+void vm_cpu::end(int exitCode)
+{
+   if(!blocked)
+      throw vm_exit{exitCode};
+}
+
+/* Await Suspend
+ * Queue the request of the VM for the next batch.
+ *
+ * <handle> point to resume the VM at
+ */
+void memory_access::await_suspend(coroutine_handle<> handle)
+{
+   vm.waiting = handle;
+   pending.push_back(&vm);
+}
+
+/* Await Resume
+ * <return> value read, ends the VM on a failed access
+ */
+int memory_access::await_resume()
+{
+   if(vm.status != SUCCESS)
+      throw vm_exit{vm.status};
+   return vm.result;
+}
+
+/* Device Access
+ * Console output (registers 1 and 2) is buffered per VM
+ * and the RNG uses the seed of the VM.  Other devices are
+ * not available to VMs.
+ *
+ * <vm> VM accessing the device
+ * <action> READ or WRITE
+ * <address> address accessed
+ * <value> value to write, or value read
+ * <return> false if the address is not in the I/O region
+ */
+bool deviceAccess(vm_context &vm, int action, int address, int *value)
+{
+   if(address < IO_BASE || address >= IO_BASE + IO_SIZE)
+      return false;
+
+   if(action == WRITE && address == CONSOLE_BASE + 1)
+      vm.output += to_string(*value);
+   else if(action == WRITE && address == CONSOLE_BASE + 2)
+      vm.output += (char)*value;
+   else if(action == READ && address == RNG_BASE)
+      *value = rng_value(rand_r(&vm.seed));
+   else if(action == WRITE && address == RNG_BASE + 1)
+      vm.seed = *value;
+   else
+      throw vm_exit{INVALID_PORT_CALL};
+   return true;
+}
+
+/* Verify VM Access
+ * Same checks as verifyAccess, for the mode of the VM.
+ *
+ * <vm> VM accessing memory
+ * <address> address being accessed
+ */
+void verifyVMAccess(vm_context &vm, int address)
+{
+   if(address < 0 || address >= MEMORY_SIZE)
+      throw vm_exit{MEMORY_OUT_OF_BOUNDS};
+   if(address >= SYS_INDEX && !vm.state.kernelMode)
+      throw vm_exit{KERNEL_MEM_ACCESS_DENIED};
+   if(address < SYS_INDEX && vm.state.kernelMode)
+      throw vm_exit{USER_MEM_ACCESS_DENIED};
+}
+
+/* Serve Batch
+ * Sends the requests of the waiting VMs to main memory
+ * with a single signal and stores each reply in its VM.
+ *
+ * <batch> VMs waiting on memory
+ */
+void serveBatch(vector<vm_context *> &batch)
+{
+   static mem_request requests[MAX_VMS];
+   static int replies[2 * MAX_VMS];
+
+   int count = batch.size();
+   for(int i = 0; i < count; i++)
+   {
+      requests[i] = batch[i]->request;
+      TRACE_PROBE2(memory_request, requests[i].action, requests[i].address);
+   }
+
+   int header[2] = { BATCH, count };
+   write(engine_writeToMem[1], header, sizeof(header));
+   write(engine_writeToMem[1], requests, count * sizeof(mem_request));
+   notify_memory(engine_process[MAIN_MEMORY]);
+
+   if(!readReply(replies, count * 2 * sizeof(int)))
+      endEngine(READ_FAILURE);
+
+   for(int i = 0; i < count; i++)
+   {
+      batch[i]->status = replies[2 * i];
+      batch[i]->result = replies[2 * i + 1];
+      TRACE_PROBE3(memory_reply, requests[i].action, requests[i].address, replies[2 * i]);
+   }
+
+   batch_count++;
+   request_count += count;
+}
+
+/* Read Reply
+ * Reads exactly size bytes from main memory.
+ *
+ * <buffer> destination
+ * <size> bytes to read
+ * <return> false if main memory closed the pipe
+ */
+bool readReply(void *buffer, size_t size)
+{
+   char *position = (char *)buffer;
+   while(size > 0)
+   {
+      ssize_t count = read(engine_readFromMem[0], position, size);
+      if(count <= 0)
+         return false;
+      position += count;
+      size -= count;
+   }
+   return true;
+}
+
+/* End Engine
+ * Ends the engine on a failure of main memory.
+ *
+ * <exitCode> Exit status value
+ */
+void endEngine(int exitCode)
+{
+   kill(engine_process[MAIN_MEMORY], SIGKILL);
+   cout << "EXIT CODE: " << exit_code_name(exitCode) << endl << endl;
+   exit(exitCode);
+}
@@ -0,0 +1,328 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Core Dump
+//   Implementation below is executed by the processor process.
+//   With --core, a run ending with an error writes a binary
+//   core file: a fixed header with the registers, flags and
+//   stacks, the last retired instruction addresses kept in a
+//   ring, and the memory image taken with one request to main
+//   memory.  The file is written with a single writev, so it
+//   costs one round trip and one system call.  The
+//   --analyze-core mode prints a core file offline.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "program.h"
+using namespace std;
+
+// Core file format version and retired PCs kept (power of two)
+#define CORE_VERSION 1
+#define CORE_PC_RING 64
+#define CORE_PC_MASK (CORE_PC_RING - 1)
+
+// Stack words and memory words around the fault printed
+#define CORE_STACK_WORDS 16
+#define CORE_CONTEXT_WORDS 8
+
+// Fixed header of a core file, followed by pcCount retired
+// PCs (oldest first) and memoryWords words of main memory
+struct core_header
+{
+   char magic[8];
+   int32_t version;
+   int32_t exitCode;
+   int32_t timer;
+   int32_t instructions;
+   int32_t faultAddress;
+   int32_t kernelMode;
+   int32_t interruptsEnabled;
+   int32_t registers[REGCOUNT];
+   int32_t inactiveSysStack;
+   int32_t inactiveProcStack;
+   int32_t pcCount;
+   int32_t memoryWords;
+};
+
+// Processor state
+extern int registers[REGCOUNT];
+extern int interrupt_timer;
+extern int instruction_counter;
+extern int inactive_sys_stack, inactive_proc_stack;
+extern int instruction_address;
+extern bool interruptEnabledFlag;
+extern bool kernelMode;
+
+// Methods
+void printInstruction(const vector<int32_t> &memory, int address);
+
+// Core file path (NULL = none)
+const char *core_file = NULL;
+
+// Addresses of the last retired instructions
+int retired_pcs[CORE_PC_RING];
+unsigned int retired_count = 0;
+
+/* Set Core File
+ * <path> file to dump the core to on an error, or NULL
+ */
+void set_core_file(const char *path)
+{
+   core_file = path;
+}
+
+/* Retire Instruction
+ * Records the address of an executed instruction.
+ *
+ * <address> address of the instruction
+ */
+void retire_instruction(int address)
+{
+   retired_pcs[retired_count++ & CORE_PC_MASK] = address;
+}
+
+/* Write Core Dump
+ * Writes the core file for a run ending with an error.
+ * Called while main memory is still running.
+ *
+ * <exitCode> exit status of the run
+ */
+void write_core_dump(int exitCode)
+{
+   if(core_file == NULL || exitCode == SUCCESS)
+      return;
+
+   core_header header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, "SIMCORE", 8);
+   header.version = CORE_VERSION;
+   header.exitCode = exitCode;
+   header.timer = interrupt_timer;
+   header.instructions = instruction_counter;
+   header.faultAddress = instruction_address;
+   header.kernelMode = kernelMode;
+   header.interruptsEnabled = interruptEnabledFlag;
+   for(int i = 0; i < REGCOUNT; i++)
+      header.registers[i] = registers[i];
+   header.inactiveSysStack = inactive_sys_stack;
+   header.inactiveProcStack = inactive_proc_stack;
+
+   // Retired PCs, oldest first
+   int pcs[CORE_PC_RING];
+   header.pcCount = retired_count < CORE_PC_RING ? retired_count : CORE_PC_RING;
+   for(int i = 0; i < header.pcCount; i++)
+      pcs[i] = retired_pcs[(retired_count - header.pcCount + i) & CORE_PC_MASK];
+
+   // Memory is left out if main memory cannot answer
+   static int image[MEMORY_SIZE];
+   header.memoryWords = dump_memory(image) ? MEMORY_SIZE : 0;
+
+   int fd = open(core_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(fd == -1)
+   {
+      cerr << "Failed to open core file " << core_file << endl;
+      return;
+   }
+   struct iovec parts[3] = {
+      { &header, sizeof(header) },
+      { pcs, header.pcCount * sizeof(int) },
+      { image, header.memoryWords * sizeof(int) }
+   };
+   if(writev(fd, parts, 3) != (ssize_t)(parts[0].iov_len + parts[1].iov_len + parts[2].iov_len))
+      cerr << "Failed to write core file " << core_file << endl;
+   close(fd);
+}
+
+/* Analyze Core
+ * Prints a core file: exit status, faulting instruction,
+ * registers, the active stack, memory around the fault and
+ * the last retired instructions.
+ *
+ * <file> core file path
+ * <return> SUCCESS, or FILE_PARSE_FAILURE for a bad file
+ */
+int analyze_core(const char *file)
+{
+   core_header header;
+   int fd = open(file, O_RDONLY);
+   if(fd == -1 || read(fd, &header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, "SIMCORE", 8) != 0 || header.version != CORE_VERSION ||
+      header.pcCount < 0 || header.pcCount > CORE_PC_RING ||
+      (header.memoryWords != 0 && header.memoryWords != MEMORY_SIZE))
+   {
+      cout << "ERROR: Not a core file: " << file << endl;
+      if(fd != -1)
+         close(fd);
+      return FILE_PARSE_FAILURE;
+   }
+
+   vector<int32_t> pcs(header.pcCount);
+   vector<int32_t> memory(header.memoryWords);
+   bool complete = read(fd, pcs.data(), pcs.size() * sizeof(int32_t)) == (ssize_t)(pcs.size() * sizeof(int32_t)) &&
+                   read(fd, memory.data(), memory.size() * sizeof(int32_t)) == (ssize_t)(memory.size() * sizeof(int32_t));
+   close(fd);
+   if(!complete)
+   {
+      cout << "ERROR: Truncated core file: " << file << endl;
+      return FILE_PARSE_FAILURE;
+   }
+
+   cout << "CORE: " << file << endl;
+   cout << "  Exit code:     " << exit_code_name(header.exitCode) << endl;
+   cout << "  Instructions:  " << header.instructions << " (timer " << header.timer << ")" << endl;
+   cout << "  Mode:          " << (header.kernelMode ? "kernel" : "user") << ", interrupts "
+        << (header.interruptsEnabled ? "enabled" : "disabled") << endl;
+   cout << "  Faulting at:   ";
+   printInstruction(memory, header.faultAddress);
+   cout << endl;
+
+   const char *names[REGCOUNT] = { "PC", "IR", "AC", "X", "Y", "SP" };
+   cout << "  Registers:    ";
+   for(int i = 0; i < REGCOUNT; i++)
+      cout << " " << names[i] << "=" << header.registers[i];
+   cout << endl;
+   cout << "  Inactive SP:   system " << header.inactiveSysStack
+        << ", user " << header.inactiveProcStack << endl;
+
+   if(memory.empty())
+      cout << "  Memory:        not captured" << endl;
+   else
+   {
+      // Active stack, from the top of stack up to its base
+      int base = header.kernelMode ? MEMORY_SIZE : SYS_INDEX;
+      int sp = header.registers[SP];
+      cout << endl << "STACK (" << (header.kernelMode ? "system" : "user") << "):" << endl;
+      if(sp < 0 || sp > base)
+         cout << "  SP out of range" << endl;
+      for(int i = max(sp, 0); i < base && i < sp + CORE_STACK_WORDS; i++)
+         cout << "  " << setw(4) << i << ": " << memory[i] << endl;
+
+      // Words around the faulting instruction
+      cout << endl << "MEMORY:" << endl;
+      int first = max(header.faultAddress - CORE_CONTEXT_WORDS, 0);
+      int last = min(header.faultAddress + CORE_CONTEXT_WORDS, MEMORY_SIZE - 1);
+      for(int i = first; i <= last; i++)
+         cout << (i == header.faultAddress ? "> " : "  ") << setw(4) << i << ": " << memory[i] << endl;
+   }
+
+   cout << endl << "LAST RETIRED INSTRUCTIONS (oldest first):" << endl;
+   for(size_t i = 0; i < pcs.size(); i++)
+   {
+      cout << "  ";
+      printInstruction(memory, pcs[i]);
+      cout << endl;
+   }
+   return SUCCESS;
+}
+
+/* Print Instruction
+ * Prints an address and, when memory was captured, the
+ * instruction stored there.
+ *
+ * <memory> memory image (may be empty)
+ * <address> instruction address
+ */
+void printInstruction(const vector<int32_t> &memory, int address)
+{
+   cout << setw(4) << address;
+   if(address < 0 || address >= (int)memory.size())
+      return;
+
+   int opcode = memory[address];
+   cout << ": " << opcode_name(opcode);
+   if(opcode_has_operand(opcode) && address + 1 < (int)memory.size())
+      cout << " " << memory[address + 1];
+}
+
+/* Opcode Name
+ * <opcode> instruction opcode
+ * <return> mnemonic of the instruction
+ */
+const char *opcode_name(int opcode)
+{
+   switch(opcode)
+   {
+      case LOAD_VAL: return "LoadValue";
+      case LOAD_ADDR: return "LoadAddr";
+      case LOAD_IND_ADDR: return "LoadIndAddr";
+      case LOAD_IDX_X_ADDR: return "LoadIdxXAddr";
+      case LOAD_IDX_Y_ADDR: return "LoadIdxYAddr";
+      case LOAD_SPX: return "LoadSpX";
+      case STORE: return "Store";
+      case GET: return "Get";
+      case PUT: return "Put";
+      case ADDX: return "AddX";
+      case ADDY: return "AddY";
+      case SUBX: return "SubX";
+      case SUBY: return "SubY";
+      case COPY_TO_X: return "CopyToX";
+      case COPY_FR_X: return "CopyFromX";
+      case COPY_TO_Y: return "CopyToY";
+      case COPY_FR_Y: return "CopyFromY";
+      case COPY_TO_SP: return "CopyToSp";
+      case COPY_FR_SP: return "CopyFromSp";
+      case JUMP: return "Jump";
+      case JUMP_IF_EQ: return "JumpIfEqual";
+      case JUMP_IF_NEQ: return "JumpIfNotEqual";
+      case JUMP_RETURN: return "Call";
+      case RETURN: return "Ret";
+      case INCX: return "IncX";
+      case DECX: return "DecX";
+      case PUSH: return "Push";
+      case POP: return "Pop";
+      case SYSCALL: return "Int";
+      case SYSRETURN: return "IRet";
+      case IN: return "In";
+      case END: return "End";
+      default: return "(invalid opcode)";
+   }
+}
+
+/* Has Operand
+ * <opcode> instruction opcode
+ * <return> true if the instruction is followed by an operand
+ */
+bool opcode_has_operand(int opcode)
+{
+   switch(opcode)
+   {
+      case LOAD_VAL:
+      case LOAD_ADDR:
+      case LOAD_IND_ADDR:
+      case LOAD_IDX_X_ADDR:
+      case LOAD_IDX_Y_ADDR:
+      case STORE:
+      case PUT:
+      case IN:
+      case JUMP:
+      case JUMP_IF_EQ:
+      case JUMP_IF_NEQ:
+      case JUMP_RETURN:
+         return true;
+      default:
+         return false;
+   }
+}
@@ -0,0 +1,372 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Built-in Devices
+//   Console, RNG, timer and disk devices of libsimos, the
+//   registers behind the device bus of the processor process
+//   (bus.cc) and of every machine (machine.cc).  A device keeps
+//   its own state, so each owner has its own devices.  The
+//   framebuffer lives in framebuffer.cc.
+
+#include <iostream>
+#include <climits>
+#include <cctype>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "program.h"
+#include "execute.h"
+using namespace std;
+
+namespace simos
+{
+
+/* Set Text
+ * <text> console input, read from the start
+ */
+template <typename Word>
+void string_input<Word>::set_text(const string &text)
+{
+   this->text = text;
+   rewind();
+}
+
+/* Rewind
+ * Reads the input from the start again, disarming the
+ * readiness interrupt.
+ */
+template <typename Word>
+void string_input<Word>::rewind()
+{
+   position = 0;
+   armed = false;
+}
+
+/* Read Int
+ * Reads the next whitespace separated integer, as the input
+ * port does once the whole input has arrived, saturating at
+ * the largest word.
+ *
+ * <return> integer value, or -1 at the end of the input
+ */
+template <typename Word>
+Word string_input<Word>::read_int()
+{
+   while(position < text.size() && isspace((unsigned char)text[position]))
+      position++;
+
+   size_t length = 0;
+   while(position + length < text.size() && !isspace((unsigned char)text[position + length]))
+      length++;
+   if(length == 0)
+      return -1;
+
+   const char *token = text.c_str() + position;
+   Word value = parse_int_token<Word>([token](size_t i) { return token[i]; }, length);
+   position += length;
+   return value;
+}
+
+/* Read Char
+ * <return> next input byte, or -1 at the end of the input
+ */
+template <typename Word>
+int string_input<Word>::read_char()
+{
+   return position < text.size() ? (unsigned char)text[position++] : -1;
+}
+
+/* Status
+ * <return> input bytes left, or -1 at the end of the input
+ */
+template <typename Word>
+int string_input<Word>::status()
+{
+   if(position < text.size())
+      return text.size() - position;
+   return -1;
+}
+
+/* Arm Interrupt
+ * The owner delivers the readiness interrupt while input is
+ * left and clears the flag.
+ */
+template <typename Word>
+void string_input<Word>::arm_interrupt()
+{
+   armed = true;
+}
+
+/* Console Device
+ * <input> console input source
+ * <output> output stream, NULL to capture the output
+ */
+template <typename Word>
+console_device<Word>::console_device(console_input<Word> *input, ostream *output)
+   : input(input), output(output)
+{
+}
+
+/* Print
+ * <text> text written to the output stream or captured
+ */
+template <typename Word>
+void console_device<Word>::print(const string &text)
+{
+   if(output != NULL)
+      *output << text;
+   else
+      captured += text;
+}
+
+/* Console Read
+ * Registers: 1 integer input, 2 char input, 3 input status.
+ */
+template <typename Word>
+bool console_device<Word>::read(int offset, Word *value)
+{
+   switch(offset)
+   {
+      case 1: *value = input->read_int(); return true;
+      case 2: *value = input->read_char(); return true;
+      case 3: *value = input->status(); return true;
+      default: return false;
+   }
+}
+
+/* Console Write
+ * Registers: 1 print as int, 2 print as char,
+ * 4 arm the input readiness interrupt.
+ */
+template <typename Word>
+bool console_device<Word>::write(int offset, Word value)
+{
+   switch(offset)
+   {
+      case 1: print(to_string(value)); return true;
+      case 2: print(string(1, (char)value)); return true;
+      case 4: input->arm_interrupt(); return true;
+      default: return false;
+   }
+}
+
+/* RNG Device
+ * Starts the generator in the state of an unseeded rand().
+ */
+template <typename Word>
+rng_device<Word>::rng_device()
+   : data()
+{
+   initstate_r(1, state, sizeof(state), &data);
+}
+
+/* Seed
+ * <seed> seed of the generator
+ */
+template <typename Word>
+void rng_device<Word>::seed(unsigned int seed)
+{
+   srandom_r(seed, &data);
+}
+
+/* RNG Read
+ * Register 0: random value between 1-100.
+ */
+template <typename Word>
+bool rng_device<Word>::read(int offset, Word *value)
+{
+   int32_t number;
+   if(offset != 0)
+      return false;
+   random_r(&data, &number);
+   *value = rng_value(number);
+   return true;
+}
+
+/* RNG Write
+ * Register 1: reseed the generator.
+ */
+template <typename Word>
+bool rng_device<Word>::write(int offset, Word value)
+{
+   if(offset != 1)
+      return false;
+   seed((unsigned int)value);
+   return true;
+}
+
+/* Timer Device
+ * <interval> interrupt timer of the owner
+ * <count> instruction counter of the owner
+ */
+template <typename Word>
+timer_device<Word>::timer_device(int &interval, function<long long()> count)
+   : interval(interval), count(count)
+{
+}
+
+/* Timer Read
+ * Registers: 0 instruction counter, 1 interrupt timer.
+ */
+template <typename Word>
+bool timer_device<Word>::read(int offset, Word *value)
+{
+   switch(offset)
+   {
+      case 0:
+         *value = (Word)count();
+	 return true;
+      case 1:
+         accesses++;
+         *value = interval;
+	 return true;
+      default:
+         return false;
+   }
+}
+
+/* Timer Write
+ * Register 1: set the interrupt timer (natural number),
+ * kernel mode only.
+ */
+template <typename Word>
+bool timer_device<Word>::write(int offset, Word value)
+{
+   if(offset != 1 || value <= 0 || value > INT_MAX)
+      return false;
+   accesses++;
+   interval = value;
+   return true;
+}
+
+/* Disk Device
+ * Closes the backing file.
+ */
+template <typename Word>
+disk_device<Word>::~disk_device()
+{
+   if(fd != -1)
+      close(fd);
+}
+
+/* Open
+ * Open the host file backing the disk.  Without a path the
+ * disk is empty.
+ *
+ * <path> host file path or NULL
+ * <return> false if the file could not be opened
+ */
+template <typename Word>
+bool disk_device<Word>::open(const char *path)
+{
+   if(path == NULL)
+      return true;
+
+   if(fd != -1)
+      close(fd);
+   fd = ::open(path, O_RDWR | O_CREAT, 0644);
+   position = 0;
+   return fd != -1;
+}
+
+/* Disk Size
+ * <return> disk size in words
+ */
+template <typename Word>
+int disk_device<Word>::size()
+{
+   struct stat info;
+   if(fd == -1 || fstat(fd, &info) == -1)
+      return 0;
+   return info.st_size / sizeof(int);
+}
+
+/* Disk Read
+ * Registers: 0 word position, 1 data word at position
+ * (position auto-increments, -1 past the end), 2 size.
+ */
+template <typename Word>
+bool disk_device<Word>::read(int offset, Word *value)
+{
+   int word;
+   switch(offset)
+   {
+      case 0:
+         *value = position;
+	 return true;
+      case 1:
+         if(fd == -1 ||
+	    pread(fd, &word, sizeof(int), (off_t)position * sizeof(int)) != sizeof(int))
+	    *value = -1;
+	 else
+	 {
+	    *value = word;
+	    position++;
+	 }
+	 return true;
+      case 2:
+         *value = size();
+	 return true;
+      default:
+         return false;
+   }
+}
+
+/* Disk Write
+ * Registers: 0 word position, 1 data word at position
+ * (position auto-increments).  Disk words are 32 bits, so
+ * a wider value fails the access.
+ */
+template <typename Word>
+bool disk_device<Word>::write(int offset, Word value)
+{
+   int word = (int)value;
+   switch(offset)
+   {
+      case 0:
+         if(value < 0 || value > INT_MAX)
+	    return false;
+         position = value;
+	 return true;
+      case 1:
+         if(fd == -1 || word != value ||
+	    pwrite(fd, &word, sizeof(int), (off_t)position * sizeof(int)) != sizeof(int))
+	    return false;
+	 position++;
+	 return true;
+      default:
+         return false;
+   }
+}
+
+// Devices of both word widths are built into libsimos
+template class string_input<int>;
+template class string_input<long long>;
+template class console_device<int>;
+template class console_device<long long>;
+template class rng_device<int>;
+template class rng_device<long long>;
+template class timer_device<int>;
+template class timer_device<long long>;
+template class disk_device<int>;
+template class disk_device<long long>;
+
+}
@@ -0,0 +1,270 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Loop Fast-Forward
+//   Implementation below is executed by the processor process.
+//   Keeps a copy of the instruction stream words the processor
+//   has fetched, and after a taken backward JUMP_IF_NEQ checks
+//   whether the loop only does X/Y/AC arithmetic.  Such loops
+//   are solved in closed form: X and Y step by a constant each
+//   iteration and AC at the branch is linear in the iteration,
+//   so the exit iteration is found without running the loop.
+//   Skipped iterations still count as executed instructions and
+//   stop short of the next timer interrupt, which is then taken
+//   at the same instruction as when interpreting.
+
+#include <limits.h>
+#include "program.h"
+using namespace std;
+
+// Longest loop body (in words) considered
+#define MAX_LOOP_WORDS 64
+
+// Processor state
+extern int registers[REGCOUNT];
+extern int interrupt_timer;
+extern int instruction_counter;
+extern bool interruptEnabledFlag;
+extern bool kernelMode;
+
+// Linear form a*AC + b*X + c*Y + k over the registers at
+// the start of an iteration
+struct linear
+{
+   long long ac, x, y, k;
+};
+
+// Methods
+linear addForms(const linear &a, const linear &b, int sign);
+long long evaluate(const linear &form, long long x, long long y, long long acValue);
+bool fitsInt(long long value);
+void checkInterrupt();
+
+// Instruction stream words fetched so far
+int code_words[MEMORY_SIZE];
+bool code_valid[MEMORY_SIZE];
+
+// Fast-forward enabled flag
+bool fast_forward = false;
+
+/* Set Fast Forward
+ * <enabled> enable loop fast-forwarding
+ */
+void set_fast_forward(bool enabled)
+{
+   fast_forward = enabled;
+}
+
+/* Record Code Word
+ * Remember a word fetched from the instruction stream.
+ *
+ * <address> address fetched
+ * <value> word at the address
+ */
+void record_code_word(int address, int value)
+{
+   if(address >= 0 && address < MEMORY_SIZE)
+   {
+      code_words[address] = value;
+      code_valid[address] = true;
+   }
+}
+
+/* Invalidate Code Word
+ * Forget a word after it has been written.
+ *
+ * <address> address written
+ */
+void invalidate_code_word(int address)
+{
+   if(address >= 0 && address < MEMORY_SIZE)
+      code_valid[address] = false;
+}
+
+/* Fast Forward Loop
+ * Called after a taken backward JUMP_IF_NEQ with PC at
+ * the loop head.  Skips as many whole iterations as can
+ * be computed in closed form.
+ *
+ * <branch> address of the JUMP_IF_NEQ instruction
+ */
+void fast_forward_loop(int branch)
+{
+   int head = registers[PC];
+   if(!fast_forward || head > branch || branch - head + 2 > MAX_LOOP_WORDS)
+      return;
+
+   // Readiness interrupts can arrive at any instruction
+   bool interruptible = interruptEnabledFlag && !kernelMode;
+   if(interruptible && input_interrupt_is_armed())
+      return;
+
+   // Registers at the start of the iteration
+   linear ac = {1, 0, 0, 0};
+   linear x = {0, 1, 0, 0};
+   linear y = {0, 0, 1, 0};
+   linear zero = {0, 0, 0, 0};
+
+   // Every value written to a register, for the overflow check
+   linear steps[MAX_LOOP_WORDS];
+   int stepCount = 0;
+
+   // Symbolically execute one iteration
+   int length = 0;
+   int address = head;
+   while(address < branch)
+   {
+      if(!code_valid[address])
+         return;
+
+      switch(code_words[address++])
+      {
+         case LOAD_VAL:
+	    if(!code_valid[address])
+	       return;
+	    ac = zero;
+	    ac.k = code_words[address++];
+	    steps[stepCount++] = ac;
+	    break;
+	 case ADDX: steps[stepCount++] = ac = addForms(ac, x, 1); break;
+	 case ADDY: steps[stepCount++] = ac = addForms(ac, y, 1); break;
+	 case SUBX: steps[stepCount++] = ac = addForms(ac, x, -1); break;
+	 case SUBY: steps[stepCount++] = ac = addForms(ac, y, -1); break;
+	 case COPY_TO_X: x = ac; break;
+	 case COPY_FR_X: ac = x; break;
+	 case COPY_TO_Y: y = ac; break;
+	 case COPY_FR_Y: ac = y; break;
+	 case INCX: x.k++; steps[stepCount++] = x; break;
+	 case DECX: x.k--; steps[stepCount++] = x; break;
+	 default:
+	    // Stores, I/O, stack and control flow end the analysis
+	    return;
+      }
+      length++;
+   }
+
+   // Loop must close with this branch back to the head
+   if(address != branch || !code_valid[branch] || !code_valid[branch + 1] ||
+      code_words[branch] != JUMP_IF_NEQ || code_words[branch + 1] != head)
+      return;
+   length++;
+
+   // X and Y must be induction variables and AC at the branch
+   // must not depend on AC from the previous iteration
+   if(x.ac != 0 || x.x != 1 || x.y != 0 ||
+      y.ac != 0 || y.x != 0 || y.y != 1 || ac.ac != 0)
+      return;
+
+   long long x0 = registers[X];
+   long long y0 = registers[Y];
+   long long dx = x.k;
+   long long dy = y.k;
+
+   // AC at the branch of iteration i is v0 + i*slope
+   long long v0 = evaluate(ac, x0, y0, 0);
+   long long slope = ac.x * dx + ac.y * dy;
+
+   // Iterations left to run, the last one falls through
+   long long iterations = LLONG_MAX;
+   if(v0 == 0)
+      iterations = 1;
+   else if(slope != 0 && -v0 % slope == 0 && -v0 / slope > 0)
+      iterations = -v0 / slope + 1;
+
+   // Stop at whole iterations before the next timer interrupt
+   if(interruptible)
+   {
+      long long remaining = interrupt_timer - instruction_counter % interrupt_timer;
+      if(remaining / length < iterations)
+         iterations = remaining / length;
+   }
+
+   // Keep the instruction counter in range
+   long long counterRoom = (INT_MAX - (long long)instruction_counter) / length;
+   if(counterRoom < iterations)
+      iterations = counterRoom;
+
+   if(iterations < 2 || iterations == LLONG_MAX)
+      return;
+
+   // From the second iteration on, every computed value is
+   // linear in the iteration, so checking the first, second
+   // and last iteration covers overflow
+   long long xLast = x0 + (iterations - 1) * dx;
+   long long yLast = y0 + (iterations - 1) * dy;
+   long long acFirst = registers[AC];
+   long long acSecond = v0;
+   long long acLast = evaluate(ac, xLast - dx, yLast - dy, 0);
+   for(int i = 0; i < stepCount; i++)
+      if(!fitsInt(evaluate(steps[i], x0, y0, acFirst)) ||
+         !fitsInt(evaluate(steps[i], x0 + dx, y0 + dy, acSecond)) ||
+         !fitsInt(evaluate(steps[i], xLast, yLast, acLast)))
+         return;
+
+   // Apply the final register state
+   registers[X] = x0 + iterations * dx;
+   registers[Y] = y0 + iterations * dy;
+   registers[AC] = evaluate(ac, xLast, yLast, 0);
+   registers[IR] = JUMP_IF_NEQ;
+   registers[PC] = registers[AC] ? head : branch + 2;
+   instruction_counter += iterations * length;
+   stats_skip(branch, iterations * length);
+
+   // Take the timer interrupt due after the last branch
+   checkInterrupt();
+}
+
+/* Add Forms
+ * <a> first form
+ * <b> second form
+ * <sign> 1 to add, -1 to subtract
+ * <return> a + sign*b
+ */
+linear addForms(const linear &a, const linear &b, int sign)
+{
+   linear sum = {a.ac + sign * b.ac, a.x + sign * b.x,
+                 a.y + sign * b.y, a.k + sign * b.k};
+   return sum;
+}
+
+/* Evaluate
+ * Value of a form for the registers at the start of an
+ * iteration.
+ *
+ * <form> linear form
+ * <x> X value
+ * <y> Y value
+ * <acValue> AC value
+ * <return> form value
+ */
+long long evaluate(const linear &form, long long x, long long y, long long acValue)
+{
+   return form.ac * acValue + form.x * x + form.y * y + form.k;
+}
+
+/* Fits Int
+ * <value> value to check
+ * <return> true if value is a valid register value
+ */
+bool fitsInt(long long value)
+{
+   return value >= INT_MIN && value <= INT_MAX;
+}
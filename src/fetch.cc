@@ -0,0 +1,414 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Decoupled Fetch Unit
+//   Implementation below is executed by both processes.  A
+//   fetch thread in the processor process runs ahead of the
+//   execution cycle along fall-through and predicted branch
+//   targets, reading instruction words over a second pipe to
+//   main memory (signalled with SIGUSR1).  Fetched words go
+//   through a single-producer, single-consumer queue tagged
+//   with an epoch.  The execution cycle takes words from the
+//   queue in order; a word for the wrong address (mispredict)
+//   or a store into an address fetched ahead starts a new
+//   epoch, which squashes the queue and redirects the thread.
+//   Words are still checked with verifyAccess when taken, so
+//   execution is exactly the same as without the unit.
+
+#include <atomic>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+#include <sched.h>
+#include "program.h"
+#include "tracepoints.h"
+using namespace std;
+
+// Queue capacity, the run-ahead depth (must be a power of two)
+#define FETCH_QUEUE_SIZE 64
+#define FETCH_QUEUE_MASK (FETCH_QUEUE_SIZE - 1)
+
+// Fetched word.  Invalid entries mark addresses the thread
+// does not fetch (address set) or the end of its stream
+// (address -1).
+struct fetch_entry
+{
+   int address;
+   int value;
+   unsigned int epoch;
+   bool valid;
+};
+
+// Main memory of the memory process
+extern int *memory;
+
+// Methods
+void fetchThread(int memoryPid);
+bool fetchWord(int memoryPid, int address, int *value);
+void pushEntry(const fetch_entry &entry);
+void redirectFetch(int address);
+unsigned long long packRedirect(unsigned int epoch, int address);
+int  streamLength(int opcode);
+void fetchSignalHandler(int signum);
+
+// Decoupled fetch enabled flag
+bool decoupled_fetch = false;
+
+// Fetch channel pipes, created before main memory is forked
+int fetchToMem[2];
+int memToFetch[2];
+
+// Queue storage.  The fetch thread only advances the head
+// and the execution cycle only advances the tail.
+fetch_entry fetch_queue[FETCH_QUEUE_SIZE];
+atomic<unsigned int> fetch_head(0);
+atomic<unsigned int> fetch_tail(0);
+
+// Current epoch and the address the thread restarts at,
+// packed so both change together (address -1: none yet)
+atomic<unsigned long long> fetch_redirect(0xffffffffULL);
+
+// Epoch of the execution cycle (only it starts new epochs)
+unsigned int fetch_epoch = 0;
+bool epoch_targeted = false;
+
+// Words fetched ahead per address and not yet taken
+atomic<int> fetched_ahead[MEMORY_SIZE];
+
+/* Set Decoupled Fetch
+ * <enabled> enable the fetch thread
+ */
+void set_decoupled_fetch(bool enabled)
+{
+   decoupled_fetch = enabled;
+}
+
+/* Open Fetch Channel
+ * Creates the pipes of the fetch channel.  Called before
+ * main memory is forked so both processes share them.
+ *
+ * <return> false if the pipes could not be created
+ */
+bool open_fetch_channel()
+{
+   if(!decoupled_fetch)
+      return true;
+   return pipe(fetchToMem) != -1 && pipe(memToFetch) != -1;
+}
+
+/* Serve Fetch Channel
+ * Main memory side: answers fetch requests on SIGUSR1.
+ * The SIGINT handler and this one block each other.
+ */
+void serve_fetch_channel()
+{
+   if(!decoupled_fetch)
+      return;
+
+   struct sigaction action;
+   action.sa_handler = fetchSignalHandler;
+   sigemptyset(&action.sa_mask);
+   sigaddset(&action.sa_mask, SIGINT);
+   action.sa_flags = SA_RESTART;
+   sigaction(SIGUSR1, &action, NULL);
+
+   // Keep SIGUSR1 out of the SIGINT handler as well
+   struct sigaction memoryAction;
+   sigaction(SIGINT, NULL, &memoryAction);
+   sigaddset(&memoryAction.sa_mask, SIGUSR1);
+   memoryAction.sa_flags |= SA_RESTART;
+   sigaction(SIGINT, &memoryAction, NULL);
+}
+
+/* Fetch Signal Handler
+ * Reads an address from the fetch channel and returns the
+ * return code and the word at the address.
+ *
+ * <signum> signal received (SIGUSR1)
+ */
+void fetchSignalHandler(int signum)
+{
+   int address;
+   int reply[2] = { READ_FAILURE, 0 };
+
+   // Pages still being streamed in are not waited for
+   read(fetchToMem[0], &address, sizeof(int));
+   if(address >= 0 && address < MEMORY_SIZE && page_is_published(address))
+   {
+      reply[0] = SUCCESS;
+      reply[1] = memory[address];
+   }
+   write(memToFetch[1], reply, sizeof(reply));
+}
+
+/* Start Fetch Unit
+ * Starts the fetch thread in the processor process.  It
+ * waits for the first redirect from the execution cycle.
+ *
+ * <memoryPid> main memory process id
+ */
+void start_fetch_unit(int memoryPid)
+{
+   if(!decoupled_fetch)
+      return;
+
+   thread fetcher(fetchThread, memoryPid);
+   fetcher.detach();
+}
+
+/* Fetch Stream Word
+ * Takes the word at an instruction stream address from the
+ * queue.  Stale entries are dropped and an entry for any
+ * other address squashes the queue and redirects the fetch
+ * thread to the address.
+ *
+ * <address> address the execution cycle fetches
+ * <value> word at the address
+ * <return> false if the caller must read main memory itself
+ */
+bool fetch_stream_word(int address, int *value)
+{
+   // Out of range addresses fail in the caller
+   if(!decoupled_fetch || address < 0 || address >= MEMORY_SIZE)
+      return false;
+
+   while(true)
+   {
+      unsigned int tail = fetch_tail.load(memory_order_relaxed);
+      if(tail == fetch_head.load(memory_order_acquire))
+      {
+         // Nothing fetched yet; make sure the thread is headed here
+         if(!epoch_targeted)
+	    redirectFetch(address);
+	 sched_yield();
+	 continue;
+      }
+
+      fetch_entry entry = fetch_queue[tail & FETCH_QUEUE_MASK];
+      fetch_tail.store(tail + 1, memory_order_release);
+      if(entry.valid)
+         fetched_ahead[entry.address]--;
+
+      // Squashed by a newer epoch
+      if(entry.epoch != fetch_epoch)
+         continue;
+
+      if(entry.address == address)
+      {
+         *value = entry.value;
+	 return entry.valid;
+      }
+
+      // Mispredicted or ended stream
+      redirectFetch(address);
+   }
+}
+
+/* Squash Fetch On Store
+ * Called once a store has reached main memory.  Words the
+ * thread fetched ahead at the address may be stale, so a
+ * new epoch drops them.  A fetch issued after this check
+ * reads the stored value.
+ *
+ * <address> address written
+ */
+void squash_fetch_on_store(int address)
+{
+   if(!decoupled_fetch || address < 0 || address >= MEMORY_SIZE)
+      return;
+
+   if(fetched_ahead[address].load() > 0)
+   {
+      fetch_epoch++;
+      epoch_targeted = false;
+      fetch_redirect.store(packRedirect(fetch_epoch, -1));
+   }
+}
+
+/* Redirect Fetch
+ * Starts a new epoch with the thread fetching from the
+ * given address.
+ *
+ * <address> next instruction stream address
+ */
+void redirectFetch(int address)
+{
+   fetch_epoch++;
+   epoch_targeted = true;
+   fetch_redirect.store(packRedirect(fetch_epoch, address));
+}
+
+/* Pack Redirect
+ * <epoch> epoch number
+ * <address> restart address or -1
+ * <return> epoch and address in one word
+ */
+unsigned long long packRedirect(unsigned int epoch, int address)
+{
+   return ((unsigned long long)epoch << 32) | (unsigned int)address;
+}
+
+/* Fetch Thread
+ * Follows the instruction stream from the last redirect:
+ * fall-through, JUMP and JUMP_RETURN targets, SYSCALL into
+ * its handler, backward conditional branches taken and
+ * forward ones not taken.  Stops at RETURN, SYSRETURN, END
+ * and invalid opcodes until the next redirect.
+ *
+ * <memoryPid> main memory process id
+ */
+void fetchThread(int memoryPid)
+{
+   unsigned int epoch = 0;
+   int pc = -1;
+
+   while(true)
+   {
+      unsigned long long redirect = fetch_redirect.load();
+      if((unsigned int)(redirect >> 32) != epoch)
+      {
+         epoch = redirect >> 32;
+	 pc = (int)(unsigned int)redirect;
+      }
+
+      if(pc < 0)
+      {
+         sched_yield();
+	 continue;
+      }
+
+      // Only main memory is fetched ahead
+      if(pc >= MEMORY_SIZE)
+      {
+         pushEntry({pc, 0, epoch, false});
+	 pushEntry({-1, 0, epoch, false});
+	 pc = -1;
+	 continue;
+      }
+
+      // Words main memory cannot give yet end the stream
+      int opcode;
+      if(!fetchWord(memoryPid, pc, &opcode))
+      {
+         pushEntry({pc, 0, epoch, false});
+	 pushEntry({-1, 0, epoch, false});
+	 pc = -1;
+	 continue;
+      }
+      pushEntry({pc, opcode, epoch, true});
+
+      int length = streamLength(opcode);
+      int operand = 0;
+      if(length == 2)
+      {
+         if(pc + 1 >= MEMORY_SIZE || !fetchWord(memoryPid, pc + 1, &operand))
+	 {
+	    pushEntry({pc + 1, 0, epoch, false});
+	    pushEntry({-1, 0, epoch, false});
+	    pc = -1;
+	    continue;
+	 }
+	 pushEntry({pc + 1, operand, epoch, true});
+      }
+
+      // Predict the next instruction
+      switch(opcode)
+      {
+         case JUMP:
+	 case JUMP_RETURN:
+	    pc = operand;
+	    break;
+	 case JUMP_IF_EQ:
+	 case JUMP_IF_NEQ:
+	    pc = operand <= pc ? operand : pc + 2;
+	    break;
+	 case SYSCALL:
+	    pc = INT_INDEX;
+	    break;
+	 case RETURN:
+	 case SYSRETURN:
+	 case END:
+	    pc = -1;
+	    break;
+	 default:
+	    pc = length ? pc + length : -1;
+	    break;
+      }
+
+      if(pc < 0)
+         pushEntry({-1, 0, epoch, false});
+   }
+}
+
+/* Fetch Word
+ * Reads a word over the fetch channel.  The address is
+ * counted as fetched ahead before the request is sent.
+ *
+ * <memoryPid> main memory process id
+ * <address> address in main memory
+ * <value> word at the address
+ * <return> false if main memory did not return the word
+ */
+bool fetchWord(int memoryPid, int address, int *value)
+{
+   fetched_ahead[address]++;
+
+   int action = READ;
+   int reply[2] = { READ_FAILURE, 0 };
+   TRACE_PROBE2(memory_request, action, address);
+   write(fetchToMem[1], &address, sizeof(int));
+   kill(memoryPid, SIGUSR1);
+   bool replied = read(memToFetch[0], reply, sizeof(reply)) == sizeof(reply);
+   TRACE_PROBE3(memory_reply, action, address, reply[0]);
+   if(!replied || reply[0] != SUCCESS)
+   {
+      fetched_ahead[address]--;
+      return false;
+   }
+   *value = reply[1];
+   return true;
+}
+
+/* Push Entry
+ * Waits for room in the queue and appends an entry.
+ *
+ * <entry> entry to append
+ */
+void pushEntry(const fetch_entry &entry)
+{
+   unsigned int head = fetch_head.load(memory_order_relaxed);
+   while(head - fetch_tail.load(memory_order_acquire) == FETCH_QUEUE_SIZE)
+      sched_yield();
+
+   fetch_queue[head & FETCH_QUEUE_MASK] = entry;
+   fetch_head.store(head + 1, memory_order_release);
+}
+
+/* Stream Length
+ * <opcode> instruction opcode
+ * <return> words of the instruction, 0 for invalid opcodes
+ */
+int streamLength(int opcode)
+{
+   if(opcode < LOAD_VAL || (opcode > IN && opcode != END))
+      return 0;
+   return opcode_has_operand(opcode) ? 2 : 1;
+}
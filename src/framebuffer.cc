@@ -0,0 +1,263 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Text Framebuffer
+//   Framebuffer device of libsimos, behind the device bus of
+//   the processor process (bus.cc) and of every machine
+//   (machine.cc).  A memory-mapped character framebuffer with
+//   control registers for the dimensions and a cursor.  Writes
+//   only mark rows dirty; the console of the owner gets the
+//   dirty rows at the configured refresh interval, on demand,
+//   or at exit.
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "program.h"
+using namespace std;
+
+namespace simos
+{
+
+/* Framebuffer Device
+ * Starts blank, with every row dirty.
+ *
+ * <console> console the frames are printed on
+ */
+template <typename Word>
+framebuffer_device<Word>::framebuffer_device(console_device<Word> &console)
+   : console(console)
+{
+   clear();
+}
+
+/* Set Refresh
+ * <interval> instructions between renders, 0 for on demand only
+ */
+template <typename Word>
+void framebuffer_device<Word>::set_refresh(int interval)
+{
+   refresh_interval = interval;
+   next_refresh = interval;
+}
+
+/* Refresh
+ * Renders on a tick past the next refresh.
+ *
+ * <count> instruction counter
+ */
+template <typename Word>
+void framebuffer_device<Word>::refresh(long long count)
+{
+   render();
+   next_refresh = (count / refresh_interval + 1) * (long long)refresh_interval;
+}
+
+/* Render
+ * Prints the dirty rows.  On a terminal only the changed rows
+ * are redrawn in place; otherwise the whole frame is printed.
+ */
+template <typename Word>
+void framebuffer_device<Word>::render()
+{
+   if(!dirty)
+      return;
+
+   bool terminal = console.output == &cout && isatty(STDOUT_FILENO);
+   string frame;
+
+   if(terminal && !screen_initialized)
+   {
+      // Clear screen once, every row is dirty after a clear
+      frame += "\033[2J";
+      screen_initialized = true;
+   }
+
+   // Off a terminal, stop after the last non-blank row
+   int rows = FB_HEIGHT;
+   if(!terminal)
+      while(rows > 0 && blankRow(rows - 1))
+         rows--;
+
+   for(int y = 0; y < rows; y++)
+   {
+      if(terminal && !dirty_rows[y])
+         continue;
+
+      // Move to the row on a terminal
+      if(terminal)
+         frame += "\033[" + to_string(y + 1) + ";1H";
+
+      string row;
+      for(int x = 0; x < FB_WIDTH; x++)
+      {
+         Word c = cells[y * FB_WIDTH + x];
+	 row += (c >= 32 && c < 127) ? (char)c : ' ';
+      }
+
+      // Trailing blanks only matter when overwriting a row
+      if(!terminal)
+         row.erase(row.find_last_not_of(' ') + 1);
+      frame += row + '\n';
+      dirty_rows[y] = false;
+   }
+
+   // Leave the terminal cursor below the framebuffer
+   if(terminal)
+      frame += "\033[" + to_string(FB_HEIGHT + 1) + ";1H";
+
+   console.print(frame);
+   if(console.output != NULL)
+      console.output->flush();
+   dirty = false;
+}
+
+/* Blank Row
+ * <y> row index
+ * <return> true if every cell in the row is blank
+ */
+template <typename Word>
+bool framebuffer_device<Word>::blankRow(int y)
+{
+   for(int x = 0; x < FB_WIDTH; x++)
+      if(cells[y * FB_WIDTH + x] != ' ' && cells[y * FB_WIDTH + x] != 0)
+         return false;
+   return true;
+}
+
+/* Clear
+ * Blank all cells, home the cursor and mark every row dirty.
+ */
+template <typename Word>
+void framebuffer_device<Word>::clear()
+{
+   for(int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+      cells[i] = ' ';
+   for(int y = 0; y < FB_HEIGHT; y++)
+      dirty_rows[y] = true;
+   cursor_x = cursor_y = 0;
+}
+
+/* Put Char
+ * Write a character at the cursor and advance it, wrapping
+ * at the end of a row.  Newline moves to the next row.  The
+ * cursor wraps back to the top after the last row.
+ *
+ * <value> character to write
+ */
+template <typename Word>
+void framebuffer_device<Word>::putChar(Word value)
+{
+   if(value != '\n')
+   {
+      cells[cursor_y * FB_WIDTH + cursor_x] = value;
+      dirty_rows[cursor_y] = true;
+      dirty = true;
+      cursor_x++;
+   }
+
+   if(value == '\n' || cursor_x == FB_WIDTH)
+   {
+      cursor_x = 0;
+      cursor_y = (cursor_y + 1) % FB_HEIGHT;
+   }
+}
+
+/* Framebuffer Read
+ * Registers: 0 width, 1 height, 2 cursor x, 3 cursor y.
+ */
+template <typename Word>
+bool framebuffer_device<Word>::read(int offset, Word *value)
+{
+   switch(offset)
+   {
+      case 0: *value = FB_WIDTH; return true;
+      case 1: *value = FB_HEIGHT; return true;
+      case 2: *value = cursor_x; return true;
+      case 3: *value = cursor_y; return true;
+      default: return false;
+   }
+}
+
+/* Framebuffer Write
+ * Registers: 2 cursor x, 3 cursor y, 4 put char at cursor,
+ * 5 render now, 6 clear.
+ */
+template <typename Word>
+bool framebuffer_device<Word>::write(int offset, Word value)
+{
+   switch(offset)
+   {
+      case 2:
+         if(value < 0 || value >= FB_WIDTH)
+	    return false;
+         cursor_x = value;
+	 return true;
+      case 3:
+         if(value < 0 || value >= FB_HEIGHT)
+	    return false;
+         cursor_y = value;
+	 return true;
+      case 4:
+         putChar(value);
+	 return true;
+      case 5:
+         render();
+	 return true;
+      case 6:
+         clear();
+	 dirty = true;
+	 return true;
+      default:
+         return false;
+   }
+}
+
+/* Cells Read
+ * One register per character cell, row major.
+ */
+template <typename Word>
+bool framebuffer_device<Word>::cells_read(int offset, Word *value)
+{
+   *value = cells[offset];
+   return true;
+}
+
+/* Cells Write
+ * One register per character cell, row major.
+ */
+template <typename Word>
+bool framebuffer_device<Word>::cells_write(int offset, Word value)
+{
+   if(cells[offset] != value)
+   {
+      cells[offset] = value;
+      dirty_rows[offset / FB_WIDTH] = true;
+      dirty = true;
+   }
+   return true;
+}
+
+// Framebuffers of both word widths are built into libsimos
+template class framebuffer_device<int>;
+template class framebuffer_device<long long>;
+
+}
@@ -0,0 +1,257 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Input Port
+//   Implementation below is executed by the processor process
+//   and provides the input port used by the IN instruction.
+//   A background reader thread pulls bytes from a host file
+//   or stdin into a single-producer, single-consumer ring
+//   buffer so the execution cycle never blocks on host I/O.
+
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <cctype>
+#include "program.h"
+#include "execute.h"
+using namespace std;
+
+// Ring buffer capacity (must be a power of two)
+#define INPUT_BUFFER_SIZE 65536
+#define INPUT_BUFFER_MASK (INPUT_BUFFER_SIZE - 1)
+
+// Methods
+void inputReader(int fd);
+int  bufferedBytes();
+char peekByte(unsigned int offset);
+void consumeBytes(unsigned int count);
+
+// Ring buffer storage.  The reader thread only advances the
+// head and the processor only advances the tail.
+char input_buffer[INPUT_BUFFER_SIZE];
+atomic<unsigned int> input_head(0);
+atomic<unsigned int> input_tail(0);
+
+// Set by the reader thread once the host stream is exhausted
+atomic<bool> input_eof(true);
+
+// Readiness interrupt armed by the user program
+bool input_interrupt_armed = false;
+
+/* Start Input Port
+ * Opens the host input and starts the background reader
+ * thread.  A path of "-" reads from stdin.  Without a path
+ * the port behaves as an input stream already at EOF.
+ *
+ * <path> host file path, "-" for stdin or NULL
+ * <return> false if the file could not be opened
+ */
+bool start_input_port(const char *path)
+{
+   if(path == NULL)
+      return true;
+
+   int fd;
+   if(strcmp(path, "-") == 0)
+      fd = STDIN_FILENO;
+   else
+      fd = open(path, O_RDONLY);
+
+   if(fd == -1)
+      return false;
+
+   // Stream is open, let the reader thread fill the buffer
+   input_eof = false;
+   thread reader(inputReader, fd);
+   reader.detach();
+   return true;
+}
+
+/* Input Reader
+ * Background thread routine.  Reads the host stream in
+ * chunks and copies them into the ring buffer, waiting
+ * for the processor to drain it whenever it is full.
+ *
+ * <fd> host file descriptor to read from
+ */
+void inputReader(int fd)
+{
+   char chunk[4096];
+   ssize_t count;
+
+   while((count = read(fd, chunk, sizeof(chunk))) > 0)
+   {
+      ssize_t copied = 0;
+      while(copied < count)
+      {
+         unsigned int head = input_head.load(memory_order_relaxed);
+         unsigned int tail = input_tail.load(memory_order_acquire);
+
+	 // Wait for the processor if the buffer is full
+	 if(head - tail == INPUT_BUFFER_SIZE)
+	 {
+	    usleep(100);
+	    continue;
+	 }
+
+	 input_buffer[head & INPUT_BUFFER_MASK] = chunk[copied++];
+	 input_head.store(head + 1, memory_order_release);
+      }
+   }
+
+   if(fd != STDIN_FILENO)
+      close(fd);
+   input_eof.store(true, memory_order_release);
+}
+
+/* Buffered Bytes
+ * Number of bytes available to the processor.
+ *
+ * <return> byte count in the ring buffer
+ */
+int bufferedBytes()
+{
+   return input_head.load(memory_order_acquire) -
+          input_tail.load(memory_order_relaxed);
+}
+
+/* Peek Byte
+ * Look at a buffered byte without consuming it.
+ *
+ * <offset> offset from the oldest buffered byte
+ * <return> byte at that offset
+ */
+char peekByte(unsigned int offset)
+{
+   unsigned int tail = input_tail.load(memory_order_relaxed);
+   return input_buffer[(tail + offset) & INPUT_BUFFER_MASK];
+}
+
+/* Consume Bytes
+ * Release bytes back to the reader thread.
+ *
+ * <count> number of bytes to consume
+ */
+void consumeBytes(unsigned int count)
+{
+   unsigned int tail = input_tail.load(memory_order_relaxed);
+   input_tail.store(tail + count, memory_order_release);
+}
+
+/* Input Port Status
+ * Non-blocking status of the input port.
+ *
+ * <return> bytes buffered, 0 if none yet, -1 if EOF reached
+ */
+int input_port_status()
+{
+   // Check EOF before the count so no late bytes are missed
+   bool eof = input_eof.load(memory_order_acquire);
+   int available = bufferedBytes();
+
+   if(available > 0)
+      return available;
+   return eof ? -1 : 0;
+}
+
+/* Input Port Read Char
+ * Non-blocking read of the next character.
+ *
+ * <return> character value, or -1 if nothing is buffered
+ */
+int input_port_read_char()
+{
+   if(bufferedBytes() == 0)
+      return -1;
+
+   int value = (unsigned char)peekByte(0);
+   consumeBytes(1);
+   return value;
+}
+
+/* Input Port Read Int
+ * Non-blocking read of the next whitespace separated integer.
+ * Leading whitespace is consumed.  The token is only consumed
+ * once its delimiter (or EOF) has arrived in the buffer.
+ * Values past the range of an int saturate at INT_MAX.
+ *
+ * <return> integer value, or -1 if no complete token is buffered
+ */
+int input_port_read_int()
+{
+   bool eof = input_eof.load(memory_order_acquire);
+   int available = bufferedBytes();
+
+   // Skip leading whitespace
+   int skipped = 0;
+   while(skipped < available && isspace((unsigned char)peekByte(skipped)))
+      skipped++;
+   consumeBytes(skipped);
+   available -= skipped;
+
+   // Find the end of the token
+   int length = 0;
+   while(length < available && !isspace((unsigned char)peekByte(length)))
+      length++;
+
+   // Token incomplete until its delimiter or EOF arrives
+   if(length == 0 || (length == available && !eof))
+      return -1;
+
+   int value = parse_int_token<int>(peekByte, length);
+   consumeBytes(length);
+   return value;
+}
+
+/* Arm Input Interrupt
+ * Requests a one-shot readiness interrupt which fires once
+ * data (or EOF) is available on the input port.
+ */
+void arm_input_interrupt()
+{
+   input_interrupt_armed = true;
+}
+
+/* Input Interrupt Is Armed
+ * <return> true while the readiness interrupt is armed
+ */
+bool input_interrupt_is_armed()
+{
+   return input_interrupt_armed;
+}
+
+/* Take Input Interrupt
+ * Checks and disarms the readiness interrupt.  Only call
+ * when the processor is able to take the interrupt.
+ *
+ * <return> true if the interrupt should be delivered now
+ */
+bool take_input_interrupt()
+{
+   if(input_interrupt_armed && input_port_status() != 0)
+   {
+      input_interrupt_armed = false;
+      return true;
+   }
+   return false;
+}
@@ -0,0 +1,390 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the 
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Program Loader
+//   Parses a user program input file into a memory image.
+//   Each line is either a value loaded at the current address,
+//   a ".address" directive moving the load address, or a
+//   comment.  Large files are split at line boundaries and
+//   the chunks parsed on parallel threads into runs of values
+//   whose addresses are resolved once every chunk is parsed.
+
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <limits.h>
+#include "program.h"
+using namespace std;
+
+namespace simos
+{
+
+// Files at least this large are parsed in parallel, with at
+// least this much text per thread
+#define PARALLEL_LOAD_BYTES (1 << 20)
+
+// Values loaded at consecutive addresses.  Anchored runs
+// follow a ".address" directive in the same chunk; other
+// runs start at an offset from the address the chunk
+// starts loading at, which is only known once the chunks
+// before it are parsed.
+struct load_run
+{
+   bool anchored;
+   long long start;
+   vector<int> values;
+};
+
+// Chunk of program text and the runs parsed from it
+struct load_chunk
+{
+   const char *begin;
+   const char *end;
+   vector<load_run> runs;
+   bool anchoredEnd;
+   long long endAddress;
+   bool failed;
+};
+
+// Methods
+template <typename Word>
+bool loadStream(istream &file_stream, Word image[]);
+int  parseLine(const char *c_line, size_t length, long long &number, long long limit);
+long long parseNumber(const char *c_line, size_t length, size_t start, long long limit);
+bool loadParallel(const string &text, int image[], int threads);
+void parseChunk(load_chunk &chunk);
+
+/* Load Program
+ * Opens and parses the input user program file into
+ * the memory image.  Large files are parsed in parallel.
+ *
+ * <file> input file path
+ * <image> memory image of MEMORY_SIZE words to populate
+ * <return> true if the file was parsed successfully
+ */
+bool load_program(const char *file, int image[])
+{
+   ifstream file_stream;
+   file_stream.open(file);
+
+   // If file cannot be opened, fail the load
+   if(!file_stream.is_open())
+      return false;
+
+   // Split large files across the available cores.  Pipes
+   // cannot seek, so they are parsed line by line.
+   file_stream.seekg(0, ios::end);
+   long long size = file_stream.tellg();
+   if(size < 0)
+      file_stream.clear();
+   else
+      file_stream.seekg(0, ios::beg);
+   int threads = min((long long)thread::hardware_concurrency(), size / PARALLEL_LOAD_BYTES);
+   if(threads > 1 && file_stream.good())
+   {
+      string text(size, '\0');
+      file_stream.read(&text[0], size);
+      file_stream.close();
+      return loadParallel(text, image, threads);
+   }
+
+   bool success = load_program_stream(file_stream, image);
+   file_stream.close();
+   return success;
+}
+
+/* Load Program Stream
+ * Parses user program text into the memory image.
+ *
+ * <file_stream> program text
+ * <image> memory image of MEMORY_SIZE words to populate
+ * <return> true if the text was parsed successfully
+ */
+bool load_program_stream(istream &file_stream, int image[])
+{
+   return loadStream(file_stream, image);
+}
+
+/* Load Program Stream (64-bit words)
+ * As above, for an image of 64-bit words.
+ */
+bool load_program_stream(istream &file_stream, long long image[])
+{
+   return loadStream(file_stream, image);
+}
+
+/* Load Stream
+ * Parses program text into an image of either word width.
+ *
+ * <file_stream> program text
+ * <image> memory image of MEMORY_SIZE words to populate
+ * <return> true if the text was parsed successfully
+ */
+template <typename Word>
+bool loadStream(istream &file_stream, Word image[])
+{
+   // Process the input text
+   bool success = false;
+   try{
+      // If stream can be read...
+      if(file_stream.good())
+      {
+         std::string line;
+	 long long address = 0; // starting at address 0
+	 Word number;
+
+	 // While not EOF and a line exists
+	 while(getline(file_stream, line))
+	 {
+	    int operation = parse_program_line(line.c_str(), line.length(), number);
+
+	    // Process the line based on the operation
+	    if(operation == JUMP_AHEAD)
+	    {
+	       // For jump, set the address to the value
+	       address = number;
+	    }
+	    else if(operation == LOAD)
+	    {
+	       // For load, set the value at the current address
+	       // Address must be inside main memory
+	       if(address < 0 || address >= MEMORY_SIZE)
+	          throw FILE_PARSE_FAILURE;
+	       image[address] = number;
+	       address++;
+	    }
+	 }
+	 // If no errors thrown, return success 
+         success = true;
+      }
+   }catch(...)
+   {
+      success = false;
+   }
+
+   return success;
+}
+
+/* Parse Line
+ * Finds the operation of a line of program text.
+ * Throws FILE_PARSE_FAILURE for a malformed number.
+ *
+ * <c_line> line text
+ * <length> line length
+ * <number> address of a jump or value of a load
+ * <return> JUMP_AHEAD, LOAD or SKIP
+ */
+int parse_program_line(const char *c_line, size_t length, int &number)
+{
+   long long value = 0;
+   int operation = parseLine(c_line, length, value, INT_MAX);
+   number = value;
+   return operation;
+}
+
+/* Parse Line (64-bit words)
+ * As above, for values up to the largest 64-bit word.
+ */
+int parse_program_line(const char *c_line, size_t length, long long &number)
+{
+   return parseLine(c_line, length, number, LLONG_MAX);
+}
+
+/* Parse Line
+ * <c_line> line text
+ * <length> line length
+ * <number> address of a jump or value of a load
+ * <limit> largest value of a word
+ * <return> JUMP_AHEAD, LOAD or SKIP
+ */
+int parseLine(const char *c_line, size_t length, long long &number, long long limit)
+{
+   // Go through each line until a char is found
+   for(size_t i = 0; i < length; i++)
+   {
+      // Skip spaces
+      if(c_line[i] == ' ')
+         continue;
+
+      // If '.' encountered, this is a JUMP_AHEAD
+      if(c_line[i] == '.')
+      {
+         number = parseNumber(c_line, length, i + 1, limit);
+	 return JUMP_AHEAD;
+      }
+      // If # is encountered, this is a LOAD
+      if(isdigit(c_line[i]))
+      {
+         number = parseNumber(c_line, length, i, limit);
+	 return LOAD;
+      }
+      // Else, this is a comment
+      return SKIP;
+   }
+
+   // Empty lines are skipped
+   return SKIP;
+}
+
+/* Parse Number
+ * Reads the digits starting at an index, failing like stoi
+ * on no digits or a value too large for a word.
+ *
+ * <c_line> line text
+ * <length> line length
+ * <start> index of the first digit
+ * <limit> largest value of a word
+ * <return> value of the digits
+ */
+long long parseNumber(const char *c_line, size_t length, size_t start, long long limit)
+{
+   long long value = 0;
+   size_t i = start;
+   while(i < length && isdigit(c_line[i]))
+   {
+      int digit = c_line[i] - '0';
+      if(value > (limit - digit) / 10)
+         throw FILE_PARSE_FAILURE;
+      value = value * 10 + digit;
+      i++;
+   }
+   if(i == start)
+      throw FILE_PARSE_FAILURE;
+   return value;
+}
+
+/* Load Parallel
+ * Splits the text at line boundaries, parses the chunks on
+ * parallel threads, then resolves the start address of each
+ * chunk with a prefix pass over the chunks.  Runs are copied
+ * into the image in file order so later lines still
+ * overwrite earlier ones.
+ *
+ * <text> program text
+ * <image> memory image of MEMORY_SIZE words to populate
+ * <threads> number of chunks and threads
+ * <return> true if the text was parsed successfully
+ */
+bool loadParallel(const string &text, int image[], int threads)
+{
+   // Split at line boundaries
+   vector<load_chunk> chunks(threads);
+   const char *begin = text.data();
+   const char *end = text.data() + text.size();
+   for(int i = 0; i < threads; i++)
+   {
+      const char *split = begin + (end - begin) / (threads - i);
+      while(split < end && split > begin && split[-1] != '\n')
+         split++;
+      chunks[i].begin = begin;
+      chunks[i].end = split;
+      begin = split;
+   }
+
+   // Parse the chunks
+   vector<thread> parsers;
+   for(int i = 1; i < threads; i++)
+      parsers.push_back(thread(parseChunk, ref(chunks[i])));
+   parseChunk(chunks[0]);
+   for(size_t i = 0; i < parsers.size(); i++)
+      parsers[i].join();
+
+   // Resolve addresses in file order and fill the image
+   long long entry = 0;
+   for(int i = 0; i < threads; i++)
+   {
+      load_chunk &chunk = chunks[i];
+      if(chunk.failed)
+         return false;
+
+      for(size_t r = 0; r < chunk.runs.size(); r++)
+      {
+         load_run &run = chunk.runs[r];
+	 long long start = run.anchored ? run.start : entry + run.start;
+	 // Addresses must be inside main memory
+	 if(start < 0 || start + (long long)run.values.size() > MEMORY_SIZE)
+	    return false;
+	 copy(run.values.begin(), run.values.end(), image + start);
+      }
+
+      entry = chunk.anchoredEnd ? chunk.endAddress : entry + chunk.endAddress;
+   }
+
+   return true;
+}
+
+/* Parse Chunk
+ * Parses the lines of a chunk into runs.  Addresses are
+ * relative to the start of the chunk until the first
+ * ".address" directive.
+ *
+ * <chunk> chunk to parse
+ */
+void parseChunk(load_chunk &chunk)
+{
+   long long address = 0;
+   bool anchored = false;
+   bool newRun = true;
+   int number;
+
+   chunk.failed = false;
+   try{
+      const char *line = chunk.begin;
+      while(line < chunk.end)
+      {
+         const char *lineEnd = line;
+	 while(lineEnd < chunk.end && *lineEnd != '\n')
+	    lineEnd++;
+
+	 int operation = parse_program_line(line, lineEnd - line, number);
+	 if(operation == JUMP_AHEAD)
+	 {
+	    anchored = true;
+	    address = number;
+	    newRun = true;
+	 }
+	 else if(operation == LOAD)
+	 {
+	    if(newRun)
+	    {
+	       chunk.runs.push_back({anchored, address, vector<int>()});
+	       newRun = false;
+	    }
+	    chunk.runs.back().values.push_back(number);
+	    address++;
+	 }
+
+	 line = lineEnd + 1;
+      }
+   }catch(...)
+   {
+      chunk.failed = true;
+   }
+
+   chunk.anchoredEnd = anchored;
+   chunk.endAddress = address;
+}
+
+}
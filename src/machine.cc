@@ -0,0 +1,817 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Embedded Machine
+//   Implementation below is executed in the process embedding
+//   libsimos, or by the processor process for --in-process.
+//   A machine follows run_execution_cycle of the processor and
+//   runs the same execute core (execute.h) and built-in devices
+//   (devices.cc, framebuffer.cc), but keeps every piece of state
+//   in the object and main memory in a local array, so a run is
+//   a series of function calls instead of pipe round trips to a
+//   forked main memory process.  Errors end the run with its
+//   exit code instead of exiting the host.  The machine is a
+//   template on its word, int or long long, and both widths are
+//   instantiated here: each gets its own copy of the dispatch
+//   loop and memory paths, with register arithmetic wrapping
+//   around at the width of the word.
+
+#include <iostream>
+#include <fstream>
+#include <climits>
+#include "program.h"
+#include "simos.h"
+#include "execute.h"
+using namespace std;
+
+namespace simos
+{
+
+// The public names of simos.h stand for the private ones
+static_assert(memory_words == MEMORY_SIZE && system_base == SYS_INDEX);
+static_assert(timer_vector == SYS_INDEX && input_vector == INPUT_INDEX &&
+              syscall_vector == INT_INDEX);
+static_assert(io_base == IO_BASE && io_size == IO_SIZE && io_page_words == IO_PAGE_SIZE);
+static_assert((int)REGCOUNT == (int)::REGCOUNT && (int)SP == (int)::SP);
+static_assert((int)ERRCOUNT == (int)::ERRCOUNT &&
+              (int)MEMORY_ALLOC_FAILURE == (int)::MEMORY_ALLOC_FAILURE);
+
+// Ends a run with its exit code
+struct machine_exit
+{
+   int code;
+};
+
+// Registers, memory and devices of a machine, private to
+// libsimos
+template <typename Word>
+struct __attribute__((visibility("hidden"))) basic_machine<Word>::state
+{
+   // Execute core policy: memory is the local array and
+   // errors end the run through machine_exit
+   struct cpu_policy
+   {
+      typedef Word word;
+      state &machine;
+      Word *registers;
+
+      Word fetch_operand() { return machine.fetchOperand(); }
+      Word fetch_target() { return machine.readMemory(registers[PC]); }
+      Word read(Word address) { return machine.readMemory(address); }
+      void write(Word address, Word value) { machine.writeMemory(address, value); }
+      Word read_target(Word address) { return machine.readMemory(address); }
+      void write_target(Word address, Word value) { machine.writeMemory(address, value); }
+      Word read_port(Word port) { return machine.readPort(port); }
+      void write_port(Word port, Word value) { machine.writePort(port, value); }
+      void syscall(int address) { machine.syscall(address); }
+      void return_syscall() { machine.returnSyscall(); }
+      void end(int code) { throw machine_exit{code}; }
+   };
+
+   state();
+
+   // Methods
+   void execute();
+   Word fetchOperand();
+   void verifyAccess(Word address);
+   void verifyDeviceAccess(const device &dev, Word address);
+   Word readMemory(Word address);
+   void writeMemory(Word address, Word value);
+   Word readPort(Word port);
+   void writePort(Word port, Word value);
+   void syscall(int address);
+   void returnSyscall();
+   void runNativeHandler(interrupt_handler &handler, int address);
+   interrupt_handler *nativeHandlerAt(int vector);
+   int  findDevice(Word address) const;
+   bool registerDevice(const device &dev);
+   void registerBuiltinDevices();
+
+   // Memory, registers and flags
+   vector<Word> memory;
+   Word registers[REGCOUNT];
+   Word inactive_sys_stack, inactive_proc_stack;
+   bool interruptEnabledFlag;
+   bool kernelMode;
+
+   // Timer and counters
+   int interrupt_timer;
+   long long instruction_counter;
+   long long interrupts_taken;
+
+   // Exit status once halted
+   bool stopped;
+   int exitCode;
+
+   // Device bus.  Table entries index devices, -1 = unmapped.
+   vector<device> devices;
+   vector<int> device_table;
+
+   // Native handlers of the timer, input and system call
+   // vectors (empty = simulated)
+   interrupt_handler native_handlers[VECTOR_COUNT];
+
+   // Built-in devices
+   string_input<Word> input;
+   console_device<Word> console;
+   rng_device<Word> rng;
+   timer_device<Word> timer;
+   disk_device<Word> disk;
+   framebuffer_device<Word> framebuffer;
+};
+
+/* Machine State
+ * Empty memory with the built-in devices mapped.  Output is
+ * captured and the timer interrupt is off.
+ */
+template <typename Word>
+basic_machine<Word>::state::state()
+   : memory(MEMORY_SIZE, 0),
+     interrupt_timer(0),
+     instruction_counter(0),
+     device_table(IO_SIZE >> IO_PAGE_SHIFT, -1),
+     console(&input, NULL),
+     timer(interrupt_timer, [this] { return instruction_counter; }),
+     framebuffer(console)
+{
+   registerBuiltinDevices();
+}
+
+/* Machine
+ * Creates a machine with empty memory and the built-in
+ * devices.  The timer interrupt is off until set_timer is
+ * called.
+ */
+template <typename Word>
+basic_machine<Word>::basic_machine()
+   : self(new state)
+{
+   reset();
+}
+
+/* Machine Destructor
+ * Closes the disk file, if any.
+ */
+template <typename Word>
+basic_machine<Word>::~basic_machine()
+{
+}
+
+/* Load File
+ * <file> program file path
+ * <return> false if the file could not be parsed
+ */
+template <typename Word>
+bool basic_machine<Word>::load_file(const string &file)
+{
+   vector<Word> image(MEMORY_SIZE, 0);
+   if constexpr(sizeof(Word) == sizeof(int))
+   {
+      // 32-bit words take the processor's loader, parallel
+      // for large files
+      if(!load_program(file.c_str(), image.data()))
+         return false;
+   }
+   else
+   {
+      ifstream program(file);
+      if(!program.is_open() || !load_program_stream(program, image.data()))
+         return false;
+   }
+   return load_image(image);
+}
+
+/* Load Stream
+ * <program> program text
+ * <return> false if the text could not be parsed
+ */
+template <typename Word>
+bool basic_machine<Word>::load_stream(istream &program)
+{
+   vector<Word> image(MEMORY_SIZE, 0);
+   if(!load_program_stream(program, image.data()))
+      return false;
+   return load_image(image);
+}
+
+/* Load Image
+ * <image> memory image, at most MEMORY_SIZE words
+ * <return> false if the image does not fit in memory
+ */
+template <typename Word>
+bool basic_machine<Word>::load_image(const vector<Word> &image)
+{
+   if(image.size() > MEMORY_SIZE)
+      return false;
+   fill(self->memory.begin(), self->memory.end(), 0);
+   copy(image.begin(), image.end(), self->memory.begin());
+   reset();
+   return true;
+}
+
+/* Reset
+ * Puts the CPU in its initial state, as run_processor does,
+ * keeping memory, devices and configuration.
+ */
+template <typename Word>
+void basic_machine<Word>::reset()
+{
+   state &m = *self;
+   for(int i = 0; i < REGCOUNT; i++)
+      m.registers[i] = 0;
+   m.inactive_sys_stack = MEMORY_SIZE;
+   m.registers[SP] = m.inactive_proc_stack = SYS_INDEX;
+   m.interruptEnabledFlag = true;
+   m.kernelMode = false;
+   m.instruction_counter = 0;
+   m.interrupts_taken = 0;
+   m.timer.accesses = 0;
+   m.stopped = false;
+   m.exitCode = SUCCESS;
+   m.input.rewind();
+}
+
+/* Set Timer
+ * <instructions> instruction count till timeout, 0 = off
+ */
+template <typename Word>
+void basic_machine<Word>::set_timer(int instructions)
+{
+   if(instructions >= 0)
+      self->interrupt_timer = instructions;
+}
+
+/* Set Seed
+ * <seed> seed of the RNG device
+ */
+template <typename Word>
+void basic_machine<Word>::set_seed(unsigned int seed)
+{
+   self->rng.seed(seed);
+}
+
+/* Set Input
+ * <text> text read through the console input registers
+ */
+template <typename Word>
+void basic_machine<Word>::set_input(const string &text)
+{
+   self->input.set_text(text);
+}
+
+/* Set Output
+ * <stream> stream for console output, or NULL to capture it
+ */
+template <typename Word>
+void basic_machine<Word>::set_output(ostream *stream)
+{
+   self->console.output = stream;
+}
+
+/* Set Disk
+ * <file> host file backing the disk device, created if missing
+ * <return> false if the file could not be opened
+ */
+template <typename Word>
+bool basic_machine<Word>::set_disk(const string &file)
+{
+   return self->disk.open(file.c_str());
+}
+
+/* Set Framebuffer Refresh
+ * <instructions> instructions between renders of the
+ * framebuffer, 0 for on demand and at the end of the run only
+ */
+template <typename Word>
+void basic_machine<Word>::set_framebuffer_refresh(int instructions)
+{
+   if(instructions >= 0)
+      self->framebuffer.set_refresh(instructions);
+}
+
+/* Register Device
+ * Map a device into the I/O region, with the rules of the
+ * device bus: page aligned, inside the region, no overlap.
+ *
+ * <dev> device description and callbacks
+ * <return> false if the device could not be mapped
+ */
+template <typename Word>
+bool basic_machine<Word>::register_device(const device &dev)
+{
+   return self->registerDevice(dev);
+}
+
+/* Set Native Handler
+ * <vector> SYS_INDEX, INPUT_INDEX or INT_INDEX
+ * <handler> host handler, or empty for the simulated one
+ * <return> false if the address is not an interrupt vector
+ */
+template <typename Word>
+bool basic_machine<Word>::set_native_handler(int vector, interrupt_handler handler)
+{
+   interrupt_handler *slot = self->nativeHandlerAt(vector);
+   if(slot == NULL)
+      return false;
+   *slot = handler;
+   return true;
+}
+
+/* Step
+ * Fetch, execute, count and check for interrupts once.  The
+ * framebuffer is rendered when the run ends.
+ *
+ * <return> false once the machine has halted
+ */
+template <typename Word>
+bool basic_machine<Word>::step()
+{
+   state &m = *self;
+   if(m.stopped)
+      return false;
+
+   try{
+      m.execute();
+   }catch(machine_exit &end){
+      m.stopped = true;
+      m.exitCode = end.code;
+      m.framebuffer.render();
+   }
+   return !m.stopped;
+}
+
+/* Run
+ * <count> most instructions to run, negative = until halted
+ * <return> instructions executed
+ */
+template <typename Word>
+long long basic_machine<Word>::run(long long count)
+{
+   long long start = self->instruction_counter;
+   while((count < 0 || self->instruction_counter - start < count) && step())
+      ;
+   return self->instruction_counter - start;
+}
+
+/* Halted
+ * <return> true once End or an error ended the run
+ */
+template <typename Word>
+bool basic_machine<Word>::halted() const
+{
+   return self->stopped;
+}
+
+/* Exit Code
+ * <return> exit status of a halted run (exit_status)
+ */
+template <typename Word>
+int basic_machine<Word>::exit_code() const
+{
+   return self->exitCode;
+}
+
+/* Register
+ * <r> register
+ * <return> register value
+ */
+template <typename Word>
+Word basic_machine<Word>::reg(register_id r) const
+{
+   return self->registers[r];
+}
+
+/* Set Register
+ * <r> register
+ * <value> new register value
+ */
+template <typename Word>
+void basic_machine<Word>::set_reg(register_id r, Word value)
+{
+   self->registers[r] = value;
+}
+
+/* Peek
+ * <address> main memory address
+ * <return> word at the address, 0 outside main memory
+ */
+template <typename Word>
+Word basic_machine<Word>::peek(int address) const
+{
+   if(address < 0 || address >= MEMORY_SIZE)
+      return 0;
+   return self->memory[address];
+}
+
+/* Poke
+ * Writes main memory without checking the mode.
+ *
+ * <address> main memory address
+ * <value> value to write
+ */
+template <typename Word>
+void basic_machine<Word>::poke(int address, Word value)
+{
+   if(address >= 0 && address < MEMORY_SIZE)
+      self->memory[address] = value;
+}
+
+/* Kernel Mode
+ * <return> true while in kernel mode
+ */
+template <typename Word>
+bool basic_machine<Word>::kernel_mode() const
+{
+   return self->kernelMode;
+}
+
+/* Interrupts Enabled
+ * <return> true while interrupts are enabled
+ */
+template <typename Word>
+bool basic_machine<Word>::interrupts_enabled() const
+{
+   return self->interruptEnabledFlag;
+}
+
+/* Timer
+ * <return> instruction count till timeout, 0 = off
+ */
+template <typename Word>
+int basic_machine<Word>::timer() const
+{
+   return self->interrupt_timer;
+}
+
+/* Instructions
+ * <return> instructions executed since the load
+ */
+template <typename Word>
+long long basic_machine<Word>::instructions() const
+{
+   return self->instruction_counter;
+}
+
+/* Interrupts
+ * <return> interrupts taken since the load
+ */
+template <typename Word>
+long long basic_machine<Word>::interrupts() const
+{
+   return self->interrupts_taken;
+}
+
+/* Timer Accesses
+ * <return> reads and writes of the timer register since the
+ * load, the only way a run observes its timer value
+ */
+template <typename Word>
+long long basic_machine<Word>::timer_accesses() const
+{
+   return self->timer.accesses;
+}
+
+/* Output
+ * <return> console output captured since the last clear
+ */
+template <typename Word>
+const string &basic_machine<Word>::output() const
+{
+   return self->console.captured;
+}
+
+/* Clear Output
+ * Discards the captured console output.
+ */
+template <typename Word>
+void basic_machine<Word>::clear_output()
+{
+   self->console.captured.clear();
+}
+
+/* Execute
+ * One pass of the execution cycle: fetch, execute, count,
+ * refresh the framebuffer and check for interrupts.
+ */
+template <typename Word>
+void basic_machine<Word>::state::execute()
+{
+   cpu_policy cpu{*this, registers};
+   registers[IR] = readMemory(registers[PC]);
+   registers[PC] = wrapping_add(registers[PC], (Word)1);
+   execute_instruction(cpu);
+   instruction_counter++;
+   framebuffer.tick(instruction_counter);
+
+   // Timer interrupt, else an armed input interrupt
+   if(interrupt_timer > 0 && instruction_counter % interrupt_timer == 0)
+      syscall(SYS_INDEX);
+   else if(interruptEnabledFlag && !kernelMode &&
+           input.armed && input.status() != 0)
+   {
+      input.armed = false;
+      syscall(INPUT_INDEX);
+   }
+}
+
+/* Fetch Operand
+ * <return> word at the PC, advancing the PC
+ */
+template <typename Word>
+Word basic_machine<Word>::state::fetchOperand()
+{
+   Word address = registers[PC];
+   registers[PC] = wrapping_add(address, (Word)1);
+   return readMemory(address);
+}
+
+/* Verify Access
+ * Same checks as the processor's verifyAccess.
+ *
+ * <address> address being accessed
+ */
+template <typename Word>
+void basic_machine<Word>::state::verifyAccess(Word address)
+{
+   if(address < 0 || address >= MEMORY_SIZE)
+      throw machine_exit{MEMORY_OUT_OF_BOUNDS};
+   if(address >= SYS_INDEX && !kernelMode)
+      throw machine_exit{KERNEL_MEM_ACCESS_DENIED};
+   if(address < SYS_INDEX && kernelMode)
+      throw machine_exit{USER_MEM_ACCESS_DENIED};
+}
+
+/* Verify Device Access
+ * Kernel registers of a device are denied to user mode.
+ *
+ * <dev> device mapped at the address
+ * <address> address being accessed
+ */
+template <typename Word>
+void basic_machine<Word>::state::verifyDeviceAccess(const device &dev, Word address)
+{
+   Word offset = address - dev.base;
+   if(!kernelMode && offset < 32 && (dev.kernel_registers >> offset) & 1)
+      throw machine_exit{KERNEL_MEM_ACCESS_DENIED};
+}
+
+/* Read Memory
+ * <address> address to read, in memory or a device
+ * <return> word at the address
+ */
+template <typename Word>
+Word basic_machine<Word>::state::readMemory(Word address)
+{
+   int index = findDevice(address);
+   if(index != -1)
+   {
+      device &dev = devices[index];
+      verifyDeviceAccess(dev, address);
+      Word value;
+      if(!dev.read(address - dev.base, &value))
+         throw machine_exit{INVALID_PORT_CALL};
+      return value;
+   }
+
+   verifyAccess(address);
+   return memory[address];
+}
+
+/* Write Memory
+ * <address> address to write, in memory or a device
+ * <value> value to write
+ */
+template <typename Word>
+void basic_machine<Word>::state::writeMemory(Word address, Word value)
+{
+   int index = findDevice(address);
+   if(index != -1)
+   {
+      device &dev = devices[index];
+      verifyDeviceAccess(dev, address);
+      if(!dev.write(address - dev.base, value))
+         throw machine_exit{INVALID_PORT_CALL};
+      return;
+   }
+
+   verifyAccess(address);
+   memory[address] = value;
+}
+
+/* Read Port
+ * <port> offset into the I/O region
+ * <return> device register value
+ */
+template <typename Word>
+Word basic_machine<Word>::state::readPort(Word port)
+{
+   if(port < 0 || findDevice(wrapping_add(port, (Word)IO_BASE)) == -1)
+      throw machine_exit{INVALID_PORT_CALL};
+   return readMemory(port + IO_BASE);
+}
+
+/* Write Port
+ * <port> offset into the I/O region
+ * <value> value to write
+ */
+template <typename Word>
+void basic_machine<Word>::state::writePort(Word port, Word value)
+{
+   if(port < 0 || findDevice(wrapping_add(port, (Word)IO_BASE)) == -1)
+      throw machine_exit{INVALID_PORT_CALL};
+   writeMemory(port + IO_BASE, value);
+}
+
+/* System Call
+ * Mode switch into an interrupt handler, when interrupts are
+ * enabled and the machine is in user mode.
+ *
+ * <address> interrupt handler address
+ */
+template <typename Word>
+void basic_machine<Word>::state::syscall(int address)
+{
+   if(!interruptEnabledFlag || kernelMode)
+      return;
+
+   // A native handler runs on the host instead
+   interrupt_handler *handler = nativeHandlerAt(address);
+   if(handler != NULL && *handler)
+   {
+      runNativeHandler(*handler, address);
+      return;
+   }
+
+   kernelMode = true;
+   interruptEnabledFlag = false;
+   inactive_proc_stack = registers[SP];
+   registers[SP] = inactive_sys_stack;
+   cpu_policy cpu{*this, registers};
+   push_registers(cpu);
+   interrupts_taken++;
+   registers[PC] = address;
+}
+
+/* Return Syscall
+ * Pop the registers, switch stacks and return to user mode.
+ */
+template <typename Word>
+void basic_machine<Word>::state::returnSyscall()
+{
+   cpu_policy cpu{*this, registers};
+   pop_registers(cpu);
+   inactive_sys_stack = registers[SP];
+   registers[SP] = inactive_proc_stack;
+   interruptEnabledFlag = true;
+   kernelMode = false;
+}
+
+/* Run Native Handler
+ * Takes an interrupt with a host handler, as the processor
+ * does: registers saved in a host frame, the handler run in
+ * kernel mode, the frame restored as IRet would.
+ *
+ * <handler> host handler of the vector
+ * <address> interrupt handler address
+ */
+template <typename Word>
+void basic_machine<Word>::state::runNativeHandler(interrupt_handler &handler, int address)
+{
+   native_frame frame;
+   frame.vector = address;
+   for(int i = 0; i < REGCOUNT; i++)
+      frame.registers[i] = registers[i];
+   frame.read = [this](Word address) { return readMemory(address); };
+   frame.write = [this](Word address, Word value) { writeMemory(address, value); };
+
+   interrupts_taken++;
+   kernelMode = true;
+   interruptEnabledFlag = false;
+
+   handler(frame);
+
+   for(int i = 0; i < REGCOUNT; i++)
+      registers[i] = frame.registers[i];
+   interruptEnabledFlag = true;
+   kernelMode = false;
+}
+
+/* Native Handler At
+ * <vector> interrupt handler address
+ * <return> handler slot of the vector, or NULL
+ */
+template <typename Word>
+typename basic_machine<Word>::interrupt_handler *basic_machine<Word>::state::nativeHandlerAt(int vector)
+{
+   int slot = vector_slot(vector);
+   return slot == -1 ? NULL : &native_handlers[slot];
+}
+
+/* Find Device
+ * <address> address being accessed
+ * <return> index of the device mapped there, or -1
+ */
+template <typename Word>
+int basic_machine<Word>::state::findDevice(Word address) const
+{
+   std::make_unsigned_t<Word> offset = wrapping_sub(address, (Word)IO_BASE);
+   if(offset >= IO_SIZE)
+      return -1;
+
+   int index = device_table[offset >> IO_PAGE_SHIFT];
+   if(index == -1 || address >= devices[index].base + devices[index].size)
+      return -1;
+   return index;
+}
+
+/* Register Device
+ * <dev> device description and callbacks
+ * <return> false if the device could not be mapped
+ */
+template <typename Word>
+bool basic_machine<Word>::state::registerDevice(const device &dev)
+{
+   int first = dev.base - IO_BASE;
+   int last = first + dev.size - 1;
+
+   if((int)devices.size() == MAX_DEVICES || dev.size <= 0 ||
+      first < 0 || last >= IO_SIZE ||
+      (first & IO_PAGE_MASK) != 0 || !dev.read || !dev.write)
+      return false;
+
+   for(int page = first >> IO_PAGE_SHIFT; page <= last >> IO_PAGE_SHIFT; page++)
+      if(device_table[page] != -1)
+         return false;
+
+   for(int page = first >> IO_PAGE_SHIFT; page <= last >> IO_PAGE_SHIFT; page++)
+      device_table[page] = devices.size();
+   devices.push_back(dev);
+   return true;
+}
+
+/* Register Builtin Devices
+ * Map the console, RNG, timer, disk and framebuffer devices
+ * at the addresses of the processor's device bus.
+ */
+template <typename Word>
+void basic_machine<Word>::state::registerBuiltinDevices()
+{
+   registerDevice({"console", CONSOLE_BASE, IO_PAGE_SIZE,
+                   [this](int offset, Word *value) { return console.read(offset, value); },
+                   [this](int offset, Word value) { return console.write(offset, value); }});
+   registerDevice({"rng", RNG_BASE, IO_PAGE_SIZE,
+                   [this](int offset, Word *value) { return rng.read(offset, value); },
+                   [this](int offset, Word value) { return rng.write(offset, value); }});
+   registerDevice({"timer", TIMER_BASE, IO_PAGE_SIZE,
+                   [this](int offset, Word *value) { return timer.read(offset, value); },
+                   [this](int offset, Word value) { return timer.write(offset, value); },
+                   TIMER_KERNEL_REGISTERS});
+   registerDevice({"disk", DISK_BASE, IO_PAGE_SIZE,
+                   [this](int offset, Word *value) { return disk.read(offset, value); },
+                   [this](int offset, Word value) { return disk.write(offset, value); }});
+   registerDevice({"framebuffer", FB_BASE, IO_PAGE_SIZE,
+                   [this](int offset, Word *value) { return framebuffer.read(offset, value); },
+                   [this](int offset, Word value) { return framebuffer.write(offset, value); }});
+   registerDevice({"fb-cells", FB_CELLS, FB_WIDTH * FB_HEIGHT,
+                   [this](int offset, Word *value) { return framebuffer.cells_read(offset, value); },
+                   [this](int offset, Word value) { return framebuffer.cells_write(offset, value); }});
+}
+
+/* Vector Slot
+ * <vector> interrupt handler address
+ * <return> index of the vector, or -1 for other addresses
+ */
+int vector_slot(int vector)
+{
+   switch(vector)
+   {
+      case SYS_INDEX: return 0;
+      case INPUT_INDEX: return 1;
+      case INT_INDEX: return 2;
+      default: return -1;
+   }
+}
+
+// Both word widths are built into libsimos
+template class basic_machine<int>;
+template class basic_machine<long long>;
+
+}
@@ -29,14 +29,48 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <iterator>
 #include <unistd.h>
 #include <math.h>
 #include <cstdlib>
+#include <signal.h>
 #include "program.h"
+#include "simos.h"
 using namespace std;
 
+// Usage message
+#define USAGE "Usage: program1.exe <program_file> <timer_value> [--debug] [--input <file|->] [--disk <file>]" \
+              " [--fb-refresh <instructions>] [--server <socket>] [--submit <socket>]" \
+              " [--fast-forward] [--elide-checks] [--vms <count>]" \
+              " [--decoupled-fetch]" \
+              " [--pin <processor_cpu> <memory_cpu> | --pin-auto] [--busy-poll] [--stats]" \
+              " [--checkpoint <file>] [--stream-load] [--core <file>]" \
+              " [--metrics <name>] [--profile <file>] [--in-process]" \
+              " [--native <vector>] [--word <32|64>]\n" \
+              "       program1.exe --daemon <socket>\n" \
+              "       program1.exe --analyze-core <file>\n" \
+              "       program1.exe --simtop <name> [<interval_ms>]\n" \
+              "       program1.exe --bench [<engine>...]\n" \
+              "       program1.exe --sweep <program_file> <first_timer> <last_timer>" \
+              " [--input <file>] [--fb-refresh <instructions>]" \
+              " [--native <vector>] [--limit <instructions>]\n" \
+              "       program1.exe --zygote <socket> [--pool <min> <max>] [--server <socket>] [--debug]\n" \
+              "--in-process and --word 64 run on the libsimos machine, a separate engine that" \
+              " takes only --input, --disk, --fb-refresh and --native"
+
+// Default zygote pool bounds
+#define ZYGOTE_MIN_POOL 2
+#define ZYGOTE_MAX_POOL 32
+
 // Methods
 bool existingFile(const char *path);
+bool allowOptions(const vector<string> &given, const vector<string> &allowed,
+                  const char *mode);
+int  zygoteMain(int argc, char* argv[]);
+template <typename Machine>
+int  runInProcess(const char *file, int timer, const char *inputFile, const char *diskFile,
+                  int refreshInterval, const vector<int> &nativeVectors);
 
 /* Program Main
  * Verifies if commmand-line input is valid, forks the
@@ -50,108 +84,406 @@ bool existingFile(const char *path);
  */
 int main(int argc, char* argv[])
 {
-   // Timer value and Debug flag
+   // Timer value, Debug flag, input port and disk files
    int timer;
-   bool debugMode;
+   bool debugMode = false;
+   const char *inputFile = NULL;
+   const char *diskFile = NULL;
+   int refreshInterval = 0;
+   const char *zygoteSocket = NULL;
+   int vmCount = 0;
+   bool streamLoad = false;
+   bool inProcess = false;
+   int wordBits = 32;
+   vector<int> nativeVectors;
+   vector<string> options;
+
+   // Daemon mode runs the memory server instead of a program
+   if(argc == 3 && string(argv[1]) == "--daemon")
+      return run_memory_server(argv[2]);
+
+   // Core analysis mode prints a core file
+   if(argc == 3 && string(argv[1]) == "--analyze-core")
+      return analyze_core(argv[2]);
+
+   // Monitor mode samples the metrics page of a run
+   if((argc == 3 || argc == 4) && string(argv[1]) == "--simtop")
+   {
+      try{
+         return run_simtop(argv[2], argc == 4 ? stoi(argv[3]) : 0);
+      }catch(...){
+         cout << "ERROR: Invalid options" << endl;
+         cout << USAGE << endl << endl;
+         return CLI_FAILURE;
+      }
+   }
+
+   // Benchmark mode measures every opcode on every engine
+   if(argc >= 2 && string(argv[1]) == "--bench")
+      return run_benchmark(argc, argv);
+
+   // Sweep mode runs the program for a range of timers
+   if(argc >= 5 && string(argv[1]) == "--sweep")
+      return run_sweep(argc, argv);
+
+   // Zygote mode runs the pre-forked pool server
+   if(argc >= 3 && string(argv[1]) == "--zygote")
+      return zygoteMain(argc, argv);
 
    // Verify command-line values before continuing...
    try{
-      // Must have 3-4 arguments
-      if(argc < 3 || argc > 4)
+      // Must have at least 3 arguments
+      if(argc < 3)
       {
          cout << "ERROR: Invalid options" << endl << endl;
-	 cout << "Usage: program1.exe <program_file> <timer_value> [--debug]" << endl << endl;
-         throw;
+	 cout << USAGE << endl << endl;
+         throw CLI_FAILURE;
       }
       // Third argument must be a natural number
       if(stoi(argv[2]) < 0)
       {
          cout << "ERROR: Invalid options." << endl; 
 	 cout << "Timer value must be integer greater than zero." << endl << endl;
-	 cout << "Usage: program1.exe <program_file> <timer_value> [--debug]" << endl <<endl;
-         throw;
+	 cout << USAGE << endl <<endl;
+         throw CLI_FAILURE;
       }
       // Second argument must be a file path that exists and readable
       if(!existingFile(argv[1]))
       {
          cout << "ERROR: Program file does not exist!" << endl << endl;
-	 cout << "Usage: program1.exe <program_file> <timer_value> [--debug]" << endl << endl;
-         throw;
+	 cout << USAGE << endl << endl;
+         throw CLI_FAILURE;
+      }
+
+      // Remaining arguments are options
+      for(int i = 3; i < argc; i++)
+      {
+         string option = argv[i];
+         options.push_back(option);
+
+         if(option == "--debug")
+            debugMode = true;
+         else if(option == "--input" && i + 1 < argc)
+            inputFile = argv[++i];
+         else if(option == "--disk" && i + 1 < argc)
+            diskFile = argv[++i];
+         else if(option == "--server" && i + 1 < argc)
+            set_memory_server(argv[++i]);
+         else if(option == "--fast-forward")
+            set_fast_forward(true);
+         else if(option == "--elide-checks")
+            set_static_analysis(true);
+         else if(option == "--decoupled-fetch")
+            set_decoupled_fetch(true);
+         else if(option == "--pin-auto")
+            set_auto_placement(true);
+         else if(option == "--busy-poll")
+            set_busy_poll(true);
+         else if(option == "--stats")
+            set_stats(true);
+         else if(option == "--checkpoint" && i + 1 < argc)
+            set_checkpoint_file(argv[++i]);
+         else if(option == "--stream-load")
+            streamLoad = true;
+         else if(option == "--in-process")
+            inProcess = true;
+         else if(option == "--word" && i + 1 < argc)
+         {
+            // Only the in-process machine has 64-bit words, so
+            // 64 selects that engine
+            wordBits = stoi(argv[++i]);
+            if(wordBits != 32 && wordBits != 64)
+               throw CLI_FAILURE;
+            if(wordBits == 64)
+               inProcess = true;
+         }
+         else if(option == "--native" && i + 1 < argc)
+         {
+            // Vector must be an interrupt handler address
+            int vector = stoi(argv[++i]);
+            if(!register_native_handler(vector, native_return))
+               throw CLI_FAILURE;
+            nativeVectors.push_back(vector);
+         }
+         else if(option == "--core" && i + 1 < argc)
+            set_core_file(argv[++i]);
+         else if(option == "--metrics" && i + 1 < argc)
+            set_metrics_name(argv[++i]);
+         else if(option == "--profile" && i + 1 < argc)
+            set_profile_file(argv[++i]);
+         else if(option == "--pin" && i + 2 < argc)
+         {
+            // CPU numbers must be natural numbers
+            int processorCpu = stoi(argv[++i]);
+            int memoryCpu = stoi(argv[++i]);
+            if(processorCpu < 0 || memoryCpu < 0)
+               throw CLI_FAILURE;
+            set_cpu_pinning(processorCpu, memoryCpu);
+         }
+         else if(option == "--submit" && i + 1 < argc)
+            zygoteSocket = argv[++i];
+         else if(option == "--vms" && i + 1 < argc)
+         {
+            // VM count must be between 1 and MAX_VMS
+            vmCount = stoi(argv[++i]);
+            if(vmCount < 1 || vmCount > MAX_VMS)
+               throw CLI_FAILURE;
+         }
+         else if(option == "--fb-refresh" && i + 1 < argc)
+         {
+            // Refresh interval must be a natural number
+            refreshInterval = stoi(argv[++i]);
+            if(refreshInterval < 0)
+               throw CLI_FAILURE;
+            set_framebuffer_refresh(refreshInterval);
+         }
+         else
+         {
+            cout << "ERROR: Invalid options" << endl; 
+	    cout << USAGE << endl << endl;
+            throw CLI_FAILURE;
+         }
       }
 
-      // If Fourth argument exists, it must be the --debug flag
-      string debug = "--debug";
-      if(argc == 4 && debug.compare(argv[3]) != 0)
+      // A submitted job runs with the options of the zygote
+      if(zygoteSocket != NULL && !allowOptions(options, {"--submit"}, "--submit"))
+         throw CLI_FAILURE;
+
+      // The machine has the devices but no instrumentation
+      if(inProcess && !allowOptions(options, {"--in-process", "--input", "--disk", "--fb-refresh",
+                                              "--native", "--word"},
+                                    wordBits == 64 ? "--word 64" : "--in-process"))
+         throw CLI_FAILURE;
+
+      // The native return handler replaces a lone IRet only.
+      // A program that fails to load is reported by main memory.
+      if(!nativeVectors.empty() && !inProcess)
       {
-         cout << "ERROR: Invalid options" << endl; 
-	 cout << "Usage: program1.exe <program_file> <timer_value> [--debug]" << endl << endl;
-         throw;
+         vector<int> image(MEMORY_SIZE, 0);
+         if(simos::load_program(argv[1], image.data()))
+            for(size_t i = 0; i < nativeVectors.size(); i++)
+               if(!check_native_return(nativeVectors[i], image[nativeVectors[i]]))
+                  throw CLI_FAILURE;
       }
 
       // Get the interrupt timer
       timer = stoi(argv[2], NULL, 0);
 
-      // Check if debug mode
-      if(argc == 4)
-         debugMode = true;
-      else
-         debugMode = false;
-
    }catch(...){
       return CLI_FAILURE;
    }
 
+   // Hand the job to a pre-forked pair of a zygote
+   if(zygoteSocket != NULL)
+      return submit_job(zygoteSocket, argv[1], timer);
+
+   // Run on a libsimos machine without forking main memory
+   if(inProcess && wordBits == 64)
+      return runInProcess<simos::machine64>(argv[1], timer, inputFile, diskFile,
+                                            refreshInterval, nativeVectors);
+   if(inProcess)
+      return runInProcess<simos::machine>(argv[1], timer, inputFile, diskFile,
+                                          refreshInterval, nativeVectors);
+
    // Create array of process IDs
    int processID[(int)pid_values::PIDCOUNT];
    // Get processor process id
    processID[PROCESSOR] = getpid();
 
-   // Create pipes for IPC
-   int procToMem[2];
-   int memToProc[2];
-   
-   if( pipe(procToMem) == -1 || 
-       pipe(memToProc) == -1 ) 
+   // Main memory loads while the processor runs
+   set_stream_load(streamLoad);
+
+   // Probe for the best CPUs before main memory exists
+   choose_placement();
+
+   // Second channel to main memory for the fetch unit
+   if(!open_fetch_channel())
    {
       cout << "Failed pipe creation";
       return PIPE_FAILURE;
    }
 
-   // Fork for main memory process
-   int pid = -1;
-   pid = fork();
+   // Fork for main memory process with pipes for IPC
+   int procToMem[2];
+   int memToProc[2];
+   int pid = fork_main_memory(argv[1], procToMem, memToProc, debugMode);
+   if(pid < 0)
+      return -pid;
+
+   // Parent: Processor process
+   // Store the child process pid for main memory
+   processID[MAIN_MEMORY] = pid;
+   pin_processor();
 
-   if(pid == -1)
+   // Start the input port reader in the processor process only
+   if(!start_input_port(inputFile))
    {
-      cerr << "Failed to fork" << endl;
-      return FORK_FAILURE;
+      cerr << "Failed to open input file" << endl;
+      kill(pid, SIGKILL);
+      return INPUT_FAILURE;
    }
-   else if(pid == 0)
-   {
-      // Child: Run main memory process
-      run_main_memory(argv[1], procToMem, memToProc, debugMode);
-   }
-   else
+
+   // Open the disk device backing file
+   if(!start_disk(diskFile))
    {
-      // Parent: Processor process
-      // Store the child process pid for main memory
-      processID[MAIN_MEMORY] = pid;
-
-      // Check if main memory intialized successfully
-      int loadSuccess;
-      read(memToProc[0], &loadSuccess, sizeof(loadSuccess));
-      if(!loadSuccess)
-         return FILE_PARSE_FAILURE;
-
-      // Now that main memory has initialized, have parent run as processor
-      run_processor(timer, processID, procToMem, memToProc, debugMode);
-      
+      cerr << "Failed to open disk file" << endl;
+      kill(pid, SIGKILL);
+      return DISK_FAILURE;
    }
 
+   // Check if main memory intialized successfully
+   int loadSuccess;
+   read(memToProc[0], &loadSuccess, sizeof(loadSuccess));
+   if(!loadSuccess)
+      return FILE_PARSE_FAILURE;
+
+   // Prove accesses in bounds before execution starts.  A
+   // streamed program can only be read once, by main memory.
+   if(!streamLoad)
+      analyze_program(argv[1]);
+
+   // Start fetching ahead once the program is loaded
+   start_fetch_unit(pid);
+
+   // Interleave many copies of the program on coroutines
+   if(vmCount > 0)
+      run_coroutine_engine(timer, vmCount, processID, procToMem, memToProc);
+
+   // Now that main memory has initialized, have parent run as processor
+   run_processor(timer, processID, procToMem, memToProc, debugMode);
+
    // Program should never reach this point
    return PROGRAM_PATH_FAILURE;
 }
 
+/* Run In Process
+ * Runs the program on a libsimos machine in this process,
+ * with the console on stdout and the input file read up
+ * front as the console input.  Machine is the machine type
+ * of the word width.
+ *
+ * <file> program file path
+ * <timer> instruction count till timeout
+ * <inputFile> console input file, "-" for stdin, or NULL
+ * <diskFile> disk backing file, or NULL
+ * <refreshInterval> instructions between framebuffer renders
+ * <nativeVectors> vectors served by the native return handler
+ * <return> exit status of the run, CLI_FAILURE if a vector
+ * does not hold a lone IRet
+ */
+template <typename Machine>
+int runInProcess(const char *file, int timer, const char *inputFile, const char *diskFile,
+                 int refreshInterval, const vector<int> &nativeVectors)
+{
+   Machine machine;
+   if(!machine.load_file(file))
+      return FILE_PARSE_FAILURE;
+
+   if(inputFile != NULL)
+   {
+      ifstream inputStream;
+      if(string(inputFile) != "-")
+      {
+         inputStream.open(inputFile);
+         if(!inputStream.is_open())
+         {
+            cerr << "Failed to open input file" << endl;
+            return INPUT_FAILURE;
+         }
+      }
+      istream &source = inputStream.is_open() ? inputStream : cin;
+      machine.set_input(string(istreambuf_iterator<char>(source), istreambuf_iterator<char>()));
+   }
+
+   if(diskFile != NULL && !machine.set_disk(diskFile))
+   {
+      cerr << "Failed to open disk file" << endl;
+      return DISK_FAILURE;
+   }
+
+   for(size_t i = 0; i < nativeVectors.size(); i++)
+   {
+      if(!check_native_return(nativeVectors[i], machine.peek(nativeVectors[i])))
+         return CLI_FAILURE;
+      machine.set_native_handler(nativeVectors[i], [](typename Machine::native_frame &frame) {});
+   }
+   machine.set_timer(timer);
+   machine.set_framebuffer_refresh(refreshInterval);
+   machine.set_output(&cout);
+   machine.run(-1);
+
+   cout << "EXIT CODE: " << exit_code_name(machine.exit_code()) << endl << endl;
+   return machine.exit_code();
+}
+
+/* Zygote Main
+ * Verifies the zygote command-line options and runs the
+ * zygote server.
+ *
+ * <argc> arg count
+ * <argv> command-line arguments
+ * <return> return code indicating final program state
+ */
+int zygoteMain(int argc, char* argv[])
+{
+   int minPool = ZYGOTE_MIN_POOL;
+   int maxPool = ZYGOTE_MAX_POOL;
+   bool debugMode = false;
+
+   try{
+      for(int i = 3; i < argc; i++)
+      {
+         string option = argv[i];
+
+         if(option == "--debug")
+            debugMode = true;
+         else if(option == "--server" && i + 1 < argc)
+            set_memory_server(argv[++i]);
+         else if(option == "--pool" && i + 2 < argc)
+         {
+            minPool = stoi(argv[++i]);
+            maxPool = stoi(argv[++i]);
+            if(minPool < 0 || maxPool < minPool)
+               throw CLI_FAILURE;
+         }
+         else
+            throw CLI_FAILURE;
+      }
+   }catch(...){
+      cout << "ERROR: Invalid options" << endl;
+      cout << USAGE << endl << endl;
+      return CLI_FAILURE;
+   }
+
+   return run_zygote(argv[2], minPool, maxPool, debugMode);
+}
+
+/* Allow Options
+ * Rejects options that a mode would ignore.
+ *
+ * <given> options on the command line
+ * <allowed> options the mode uses
+ * <mode> option selecting the mode
+ * <return> false, after printing the error, if another option was given
+ */
+bool allowOptions(const vector<string> &given, const vector<string> &allowed,
+                  const char *mode)
+{
+   for(size_t i = 0; i < given.size(); i++)
+   {
+      bool found = false;
+      for(size_t j = 0; j < allowed.size() && !found; j++)
+         found = (given[i] == allowed[j]);
+      if(!found)
+      {
+         cout << "ERROR: " << given[i] << " cannot be used with " << mode << endl;
+         cout << USAGE << endl << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
 /* Existing File Check
  * Check if the file exists
  *
@@ -23,7 +23,8 @@
 //   Implementation below is executed only by the main memory
 //   process which is responsible for setting up the memory
 //   space, initializing the user program from the input file
-//   as the simulated, loaded program to execute, and simply
+//   (or the memory server cache) as the simulated, loaded
+//   program to execute, and simply
 //   executing read and write operations from the processor
 //   process.
 
@@ -32,15 +33,38 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <unistd.h>
 #include <cstdlib>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/prctl.h>
 #include "program.h"
+#include "tracepoints.h"
 using namespace std;
 
-// Main Memory -- addressable memory space
-int memory[MEMORY_SIZE];
+// Main Memory -- addressable memory space.  Points at the
+// local array unless an image is mapped from the memory server.
+int local_memory[MEMORY_SIZE];
+int *memory = local_memory;
+
+// Words per page of the VM images
+#define VM_PAGE_WORDS 64
+#define VM_PAGE_COUNT ((MEMORY_SIZE + VM_PAGE_WORDS - 1) / VM_PAGE_WORDS)
+
+// Images of the VMs of the coroutine engine.  Each VM has a
+// page table whose pages point into the loaded program,
+// shared by all VMs, until the VM first stores to the page
+// and gets a private copy from the page pool.
+vector<int *> vm_pages;
+int *vm_memory = NULL;
+int vm_count = 0;
+int vm_backing = BACKING_PAGES;
+int private_pages = 0;
+
+// Hash tree built over the loaded image
+bool image_hashed = false;
 
 // I/O pipes to processor
 int *readpipe;
@@ -48,6 +72,52 @@ int *writepipe;
 
 // Methods
 void signalhandler(int signum);
+void cloneImages(int count);
+void serveBatch(int count);
+void reportFootprint();
+int  *privatePage(int vm, int page);
+bool readFully(int fd, void *buffer, size_t size);
+void hashLoadedImage();
+
+/* Fork Main Memory
+ * Creates the pipes for IPC and forks the main memory
+ * process, which loads the program file and then serves
+ * memory requests.  A NULL file makes main memory wait
+ * for the program path on the pipe (zygote pairs).
+ *
+ * <file> input file path or NULL
+ * <procToMem> pipe from processor to main memory
+ * <memToProc> pipe from main memory to processor
+ * <debugMode> debug flag
+ * <return> main memory pid, or negative error code
+ */
+int fork_main_memory(char *file, int procToMem[], int memToProc[], bool debugMode)
+{
+   if( pipe(procToMem) == -1 || 
+       pipe(memToProc) == -1 ) 
+   {
+      cout << "Failed pipe creation";
+      return -PIPE_FAILURE;
+   }
+
+   // Fork for main memory process
+   int pid = fork();
+
+   if(pid == -1)
+   {
+      cerr << "Failed to fork" << endl;
+      return -FORK_FAILURE;
+   }
+   else if(pid == 0)
+   {
+      // Child: Run main memory process, dying with the processor
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      pin_memory();
+      run_main_memory(file, procToMem, memToProc, debugMode);
+   }
+
+   return pid;
+}
 
 /* Run Main Memory
  * Initial routine for running the main memory process.
@@ -58,7 +128,7 @@ void signalhandler(int signum);
  * Waits until an I/O operation is invoked when receiving
  * a SIGINT signal.
  * 
- * <file> input file path
+ * <file> input file path, NULL to read it from the pipe
  * <rpipe> read pipe
  * <wpipe> write pipe
  * <debugMode> debug flag
@@ -67,117 +137,45 @@ void run_main_memory(char* file, int rpipe[], int wpipe[], bool debugMode)
 {
    // Process SIGINT signals
    signal(SIGINT, signalhandler);
+   // Process fetch requests of the decoupled fetch unit
+   serve_fetch_channel();
    // Assign pipes
    readpipe = rpipe;
    writepipe = wpipe;
 
-   // Process the input file
-   fstream file_stream;
-   int success = 0;
-   try{
-      file_stream.open(file);
-
-      // If file can be opened...
-      if(file_stream.is_open())
-      {
-         std::string line;
-	 int address = 0; // starting at address 0
-
-	 // While not EOF and a line exists
-	 while(getline(file_stream, line))
-	 {
-	    // If the line is not empty...
-	    if(!line.empty())
-	    {
-	       const char *c_line = line.c_str();
-               int operation, startIndex;
-
-	       // Go through each line until a char is found
-	       for(unsigned int i = 0; i<line.length(); i++)
-	       {
-	          // Skip spaces
-	          if(c_line[i] == ' ')
-	          {
-	             // ignore spaces
-	          }
-		  // If '.' encountered, this is a JUMP_AHEAD
-	          else if(c_line[i] == '.')
-	          {
-	             operation = JUMP_AHEAD;
-		     startIndex = i + 1;
-		     break;
-  	          }
-		  // If # is encountered, this is a LOAD
-	          else if(isdigit(c_line[i]))
-	          {
-	             operation = LOAD;
-		     startIndex = i;
-		     break;
-	          }
-		  // Else, this is a comment
-	          else
-	          {
-		     operation = SKIP;
-	             break;
-	          }
-	       }
-
-               // Process the line based on the operation
-	       if(operation == JUMP_AHEAD)
-	       {
-	       // For jump, process the rest of the number
-	       // and set the address to that value
-	       string jumpAddress = "";
-	       unsigned int i = startIndex;
-	       while(i < line.length() && isdigit(c_line[i]))
-	          {
-	             jumpAddress += c_line[i];
-		     i++;
-	          }
-	          address = stoi(jumpAddress);
-	       }
-	       else if(operation == LOAD)
-	       {
-	       // For load, process the rest of the number
-	       // and set the value at the current address
-	          string loadValue = "";
-	          unsigned int i = startIndex;
-	          while(i < line.length() && isdigit(c_line[i]))
-	          {
-	             loadValue += c_line[i];
-		     i++;
-	          }
-                  memory[address] = stoi(loadValue);
-                  address++;
-	       }
-	       else if(operation == SKIP)
-	       {
-	          // For skip, do nothing
-	       }
-	       else
-	       {
-	          // Else, throw error
-	          throw;
-	       }
-	    }
-	 }
-	 // If no errors thrown, return success 
-         success = 1;
-      }
-      else // Throw exception if file cannot be opened
-         throw;
-   }catch(...)
+   // Zygote pairs receive the program path once a job arrives
+   string jobFile;
+   if(file == NULL)
    {
+      int length = 0;
+      read(readpipe[0], &length, sizeof(int));
+      jobFile.resize(length);
+      read(readpipe[0], &jobFile[0], length);
+      file = &jobFile[0];
+   }
+
+   // Load the user program, from the memory server if one
+   // is attached, otherwise by parsing the input file.  A
+   // streamed program is ready once its entry page is loaded.
+   int success = 0;
+   if(stream_load_enabled())
+      success = start_stream_load(file, memory);
+   else if(attach_memory_server(file))
+      success = 1;
+   else if(simos::load_program(file, memory))
+      success = 1;
+   else
       cout << "ERROR PARSING FILE!!!!" << endl;
 
-   }
-   // Close stream
-   file_stream.close();
+   // Hash the loaded image for the memory digest
+   if(success)
+      hashLoadedImage();
 
    // DEBUG SECTION
    // If debug flag set, print a few lines from each memory section
    if(debugMode)
    {
+      wait_for_stream_load();
       // Print some address and values from user space
       for(int i = 0; i < 300; i++)
          cout << i << ": " << memory[i] << endl;
@@ -195,10 +193,11 @@ void run_main_memory(char* file, int rpipe[], int wpipe[], bool debugMode)
    // Return if main memory was successful in initialization
    write(writepipe[1], &success, sizeof(int));
 
-   // Wait for a signal to process
+   // Wait for a signal to process, or poll for requests
    while(1)
    {
-      pause();
+      if(wait_for_request(readpipe[0]))
+         signalhandler(SIGINT);
    }
 }
 
@@ -226,13 +225,17 @@ void signalhandler(int signum)
    // REad the action and the address
    read(readpipe[0], &action, sizeof(int));
    read(readpipe[0], &address, sizeof(int));
+   TRACE_PROBE2(service_start, action, address);
    
+   // The hash tree is built once a streamed load is done
+   hashLoadedImage();
+
    if(action == READ) // If read action
    {
       // For valid memory address,
       // write into write pipe the return code
       // write into write pipe the value at address
-      if(address >= 0 && address < MEMORY_SIZE)
+      if(address >= 0 && address < MEMORY_SIZE && wait_for_page(address))
       {
          returnCode = SUCCESS;
          write(writepipe[1], &returnCode, sizeof(int));
@@ -251,9 +254,11 @@ void signalhandler(int signum)
       // read again for value to write
       // write the value to the address space
       // write into write pipe the return code
-      if(address >= 0 && address < MEMORY_SIZE)
+      if(address >= 0 && address < MEMORY_SIZE && wait_for_page(address))
       {
          read(readpipe[0], &value, sizeof(int));
+         if(image_hashed)
+            merkle_update(address, memory[address], value);
          memory[address] = value;
 	 returnCode = SUCCESS;
          write(writepipe[1], &returnCode, sizeof(int));
@@ -264,9 +269,199 @@ void signalhandler(int signum)
          write(writepipe[1], &returnCode, sizeof(int));
       }
    }
+   else if(action == CLONE) // Copy the image once per VM
+   {
+      wait_for_stream_load();
+      cloneImages(address);
+   }
+   else if(action == BATCH) // Serve many VM requests at once
+   {
+      serveBatch(address);
+   }
+   else if(action == FOOTPRINT) // Shared and private VM bytes
+   {
+      reportFootprint();
+   }
+   else if(action == DIGEST) // Root of the memory hash tree
+   {
+      wait_for_stream_load();
+      hashLoadedImage();
+      unsigned long long digest = merkle_digest();
+      write(writepipe[1], &digest, sizeof(digest));
+   }
+   else if(action == DUMP) // Whole memory image
+   {
+      wait_for_stream_load();
+      write(writepipe[1], memory, MEMORY_SIZE * sizeof(int));
+   }
    else // Else, invalid memory action
    {
       returnCode = INVALID_MEM_ACTION;
       write(writepipe[1], &returnCode, sizeof(int));
    }
+
+   TRACE_PROBE2(service_end, action, address);
+}
+
+/* Clone Images
+ * Sets up one image of the loaded program per VM of the
+ * coroutine engine.  All pages start out shared; the pool
+ * for private copies is on huge pages when there are
+ * enough VMs.  Returns the status and, on success, the
+ * backing and NUMA node of the pool.
+ *
+ * <count> number of VMs
+ */
+void cloneImages(int count)
+{
+   int reply[3] = { SUCCESS, BACKING_PAGES, -1 };
+   if(count <= 0 || count > MAX_VMS)
+   {
+      reply[0] = INVALID_MEM_ACTION;
+      write(writepipe[1], reply, sizeof(int));
+      return;
+   }
+
+   size_t poolWords = (size_t)vm_count * VM_PAGE_COUNT * VM_PAGE_WORDS;
+   release_memory(vm_memory, poolWords, vm_backing);
+   poolWords = (size_t)count * VM_PAGE_COUNT * VM_PAGE_WORDS;
+   vm_memory = allocate_memory(poolWords, &vm_backing);
+   vm_count = vm_memory == NULL ? 0 : count;
+   private_pages = 0;
+   if(vm_memory == NULL)
+   {
+      reply[0] = MEMORY_ALLOC_FAILURE;
+      write(writepipe[1], reply, sizeof(int));
+      return;
+   }
+
+   vm_pages.resize((size_t)count * VM_PAGE_COUNT);
+   for(int i = 0; i < count; i++)
+      for(int page = 0; page < VM_PAGE_COUNT; page++)
+         vm_pages[i * VM_PAGE_COUNT + page] = memory + page * VM_PAGE_WORDS;
+
+   reply[1] = vm_backing;
+   reply[2] = backing_numa_node();
+   write(writepipe[1], reply, sizeof(reply));
+}
+
+/* Private Page
+ * Copy on write: gives the VM its own copy of a page it
+ * still shares with the loaded program.
+ *
+ * <vm> VM storing to the page
+ * <page> page number
+ * <return> the private page
+ */
+int *privatePage(int vm, int page)
+{
+   int *&entry = vm_pages[vm * VM_PAGE_COUNT + page];
+   int *shared = memory + page * VM_PAGE_WORDS;
+   if(entry != shared)
+      return entry;
+
+   // The last page may be partial
+   int words = min(VM_PAGE_WORDS, MEMORY_SIZE - page * VM_PAGE_WORDS);
+   entry = vm_memory + (size_t)private_pages++ * VM_PAGE_WORDS;
+   copy(shared, shared + words, entry);
+   return entry;
+}
+
+/* Serve Batch
+ * Reads a batch of VM requests, runs them in order and
+ * writes back a return code and value for each one in a
+ * single reply.
+ *
+ * <count> number of requests in the batch
+ */
+void serveBatch(int count)
+{
+   static mem_request requests[MAX_VMS];
+   static int replies[2 * MAX_VMS];
+
+   if(count <= 0 || count > MAX_VMS ||
+      !readFully(readpipe[0], requests, count * sizeof(mem_request)))
+   {
+      // Fail every request of the batch, so the engine gets
+      // the whole reply it waits for
+      int failure[2] = { INVALID_MEM_ACTION, 0 };
+      for(int i = 0; i < count; i++)
+         write(writepipe[1], failure, sizeof(failure));
+      return;
+   }
+
+   for(int i = 0; i < count; i++)
+   {
+      mem_request &request = requests[i];
+      int &returnCode = replies[2 * i];
+      int &value = replies[2 * i + 1];
+      int page = request.address / VM_PAGE_WORDS;
+      int offset = request.address % VM_PAGE_WORDS;
+      value = 0;
+
+      if(request.vm < 0 || request.vm >= vm_count)
+         returnCode = INVALID_MEM_ACTION;
+      else if(request.address < 0 || request.address >= MEMORY_SIZE)
+         returnCode = request.action == WRITE ? WRITE_FAILURE : READ_FAILURE;
+      else if(request.action == READ)
+      {
+         returnCode = SUCCESS;
+         value = vm_pages[request.vm * VM_PAGE_COUNT + page][offset];
+      }
+      else if(request.action == WRITE)
+      {
+         returnCode = SUCCESS;
+         privatePage(request.vm, page)[offset] = request.value;
+      }
+      else
+         returnCode = INVALID_MEM_ACTION;
+   }
+
+   write(writepipe[1], replies, count * 2 * sizeof(int));
+}
+
+/* Report Footprint
+ * Writes the bytes of VM image pages shared with the loaded
+ * program and the bytes of private copies.
+ */
+void reportFootprint()
+{
+   long long bytes[2];
+   bytes[0] = (long long)MEMORY_SIZE * sizeof(int);
+   bytes[1] = (long long)private_pages * VM_PAGE_WORDS * sizeof(int);
+   write(writepipe[1], bytes, sizeof(bytes));
+}
+
+/* Read Fully
+ * Reads exactly size bytes from a pipe.
+ *
+ * <fd> pipe to read
+ * <buffer> destination
+ * <size> bytes to read
+ * <return> false on end of file or error
+ */
+bool readFully(int fd, void *buffer, size_t size)
+{
+   char *position = (char *)buffer;
+   while(size > 0)
+   {
+      ssize_t count = read(fd, position, size);
+      if(count <= 0)
+         return false;
+      position += count;
+      size -= count;
+   }
+   return true;
+}
+
+/* Hash Loaded Image
+ * Builds the hash tree over the image once it is fully
+ * loaded.  Stores before then are covered by the build.
+ */
+void hashLoadedImage()
+{
+   if(image_hashed || stream_load_pending())
+      return;
+   merkle_build(memory);
+   image_hashed = true;
 }
@@ -0,0 +1,118 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Memory Hash Tree
+//   Implementation below is executed by the main memory
+//   process.  Keeps a Merkle tree over the pages of main
+//   memory.  A page hash is the sum of a hash of each
+//   (address, value) pair, so a store updates its page in
+//   constant time, then the nodes on the path to the root.
+//   The root is a digest of the whole memory state, always
+//   current, so states compare without scanning memory.
+
+#include <stdint.h>
+#include "program.h"
+using namespace std;
+
+// Words per hashed page and leaves of the tree (power of two)
+#define HASH_PAGE_WORDS 64
+#define HASH_LEAVES 32
+
+// Methods
+uint64_t mix(uint64_t value);
+uint64_t wordHash(int address, int value);
+void     updatePath(int page);
+
+// Tree nodes, root at 1 and leaves from HASH_LEAVES
+uint64_t hash_tree[2 * HASH_LEAVES];
+
+/* Merkle Build
+ * Hashes every page of an image and builds the tree.
+ *
+ * <image> main memory image
+ */
+void merkle_build(const int image[])
+{
+   for(int page = 0; page < HASH_LEAVES; page++)
+      hash_tree[HASH_LEAVES + page] = 0;
+   for(int address = 0; address < MEMORY_SIZE; address++)
+      hash_tree[HASH_LEAVES + address / HASH_PAGE_WORDS] += wordHash(address, image[address]);
+   for(int node = HASH_LEAVES - 1; node >= 1; node--)
+      hash_tree[node] = mix(hash_tree[2 * node] ^ mix(hash_tree[2 * node + 1]));
+}
+
+/* Merkle Update
+ * Updates the tree for a store.  Called before the store
+ * with the value it replaces.
+ *
+ * <address> address written
+ * <oldValue> value before the store
+ * <newValue> value stored
+ */
+void merkle_update(int address, int oldValue, int newValue)
+{
+   int page = address / HASH_PAGE_WORDS;
+   hash_tree[HASH_LEAVES + page] += wordHash(address, newValue) - wordHash(address, oldValue);
+   updatePath(page);
+}
+
+/* Merkle Digest
+ * <return> root of the tree, a digest of main memory
+ */
+uint64_t merkle_digest()
+{
+   return hash_tree[1];
+}
+
+/* Update Path
+ * Rehashes the nodes from a page up to the root.
+ *
+ * <page> page that changed
+ */
+void updatePath(int page)
+{
+   for(int node = (HASH_LEAVES + page) / 2; node >= 1; node /= 2)
+      hash_tree[node] = mix(hash_tree[2 * node] ^ mix(hash_tree[2 * node + 1]));
+}
+
+/* Word Hash
+ * <address> address of the word
+ * <value> value of the word
+ * <return> hash of the pair
+ */
+uint64_t wordHash(int address, int value)
+{
+   return mix(((uint64_t)(uint32_t)address << 32) | (uint32_t)value);
+}
+
+/* Mix
+ * 64-bit finalizer of SplitMix64.
+ *
+ * <value> value to mix
+ * <return> mixed value
+ */
+uint64_t mix(uint64_t value)
+{
+   value += 0x9e3779b97f4a7c15ULL;
+   value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+   return value ^ (value >> 31);
+}
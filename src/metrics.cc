@@ -0,0 +1,366 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Live Metrics
+//   Implementation below is executed by the processor process
+//   and by the --simtop monitor.  With --metrics, the processor
+//   publishes its counters into a page of POSIX shared memory
+//   every METRICS_BATCH instructions; between publishes the
+//   execution cycle only bumps its own counters.  The page is
+//   guarded by a sequence lock, so the monitor never blocks
+//   the processor and retries a read that raced a publish.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <atomic>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include "program.h"
+using namespace std;
+
+// Metrics page format version and instructions per publish
+#define METRICS_VERSION 1
+#define METRICS_BATCH 1024
+
+// Default monitor sampling interval (ms)
+#define SIMTOP_INTERVAL 1000
+
+// Shared page.  Odd sequence numbers mark a publish in
+// progress; every field is written between the two bumps.
+struct metrics_page
+{
+   atomic<unsigned int> sequence;
+   atomic<int> version;
+   atomic<int> processorPid;
+   atomic<int> memoryPid;
+   atomic<long long> startTime;
+   atomic<long long> publishTime;
+   atomic<long long> instructions;
+   atomic<long long> memoryRequests;
+   atomic<long long> interrupts;
+   atomic<int> pc;
+   atomic<int> kernelMode;
+   atomic<int> exited;
+   atomic<int> exitCode;
+};
+
+// Copy of the page taken by the monitor
+struct metrics_sample
+{
+   int processorPid;
+   int memoryPid;
+   long long startTime;
+   long long publishTime;
+   long long instructions;
+   long long memoryRequests;
+   long long interrupts;
+   int pc;
+   int kernelMode;
+   int exited;
+   int exitCode;
+};
+
+// Processor state
+extern int registers[REGCOUNT];
+extern int instruction_counter;
+extern long long memory_requests;
+extern long long interrupts_taken;
+extern bool kernelMode;
+extern int *process;
+
+// Methods
+void      publishMetrics(int exited, int exitCode);
+bool      readMetrics(const metrics_page *page, metrics_sample &sample);
+string    schedulerState(int pid);
+
+// Shared memory object name and the mapped page
+const char *metrics_name = NULL;
+metrics_page *metrics = NULL;
+
+// Instruction count of the next publish
+long long next_publish = METRICS_BATCH;
+
+/* Set Metrics Name
+ * <name> shared memory object to publish to, or NULL
+ */
+void set_metrics_name(const char *name)
+{
+   metrics_name = name;
+}
+
+/* Start Metrics
+ * Creates and maps the metrics page.  Called before the
+ * execution cycle starts.
+ */
+void start_metrics()
+{
+   if(metrics_name == NULL)
+      return;
+
+   int fd = shm_open(metrics_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if(fd == -1 || ftruncate(fd, sizeof(metrics_page)) == -1)
+   {
+      cerr << "Failed to create metrics page " << metrics_name << endl;
+      if(fd != -1)
+         close(fd);
+      return;
+   }
+   void *address = mmap(NULL, sizeof(metrics_page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if(address == MAP_FAILED)
+   {
+      cerr << "Failed to map metrics page " << metrics_name << endl;
+      return;
+   }
+
+   metrics = new(address) metrics_page();
+   metrics->version = METRICS_VERSION;
+   metrics->processorPid = process[PROCESSOR];
+   metrics->memoryPid = process[MAIN_MEMORY];
+   metrics->startTime = monotonic_nanos();
+   publishMetrics(0, 0);
+}
+
+/* Tick Metrics
+ * Called by the execution cycle after every instruction.  A
+ * fast-forwarded loop may move the counter past several
+ * batches at once, which publishes once.
+ *
+ * <count> instruction counter
+ */
+void tick_metrics(int count)
+{
+   if(metrics != NULL && count >= next_publish)
+   {
+      publishMetrics(0, 0);
+      next_publish = (count / METRICS_BATCH + 1) * (long long)METRICS_BATCH;
+   }
+}
+
+/* Finish Metrics
+ * Publishes the final counters and removes the name, so
+ * only monitors already attached still see the page.
+ *
+ * <exitCode> exit status of the run
+ */
+void finish_metrics(int exitCode)
+{
+   if(metrics == NULL)
+      return;
+   publishMetrics(1, exitCode);
+   shm_unlink(metrics_name);
+}
+
+/* Publish Metrics
+ * Writes the counters to the page under the sequence lock.
+ *
+ * <exited> 1 once the run has ended
+ * <exitCode> exit status of the run
+ */
+void publishMetrics(int exited, int exitCode)
+{
+   unsigned int sequence = metrics->sequence.load(memory_order_relaxed);
+   metrics->sequence.store(sequence + 1, memory_order_relaxed);
+   atomic_thread_fence(memory_order_release);
+
+   metrics->publishTime.store(monotonic_nanos(), memory_order_relaxed);
+   metrics->instructions.store(instruction_counter, memory_order_relaxed);
+   metrics->memoryRequests.store(memory_requests, memory_order_relaxed);
+   metrics->interrupts.store(interrupts_taken, memory_order_relaxed);
+   metrics->pc.store(registers[PC], memory_order_relaxed);
+   metrics->kernelMode.store(kernelMode, memory_order_relaxed);
+   metrics->exited.store(exited, memory_order_relaxed);
+   metrics->exitCode.store(exitCode, memory_order_relaxed);
+
+   metrics->sequence.store(sequence + 2, memory_order_release);
+}
+
+/* Run Simtop
+ * Monitor: samples the metrics page of a run and shows its
+ * rates, redrawing in place on a terminal.  Ends when the
+ * run exits or the processor is killed.
+ *
+ * <name> shared memory object of the run
+ * <interval> sampling interval in milliseconds
+ * <return> SUCCESS, or FILE_PARSE_FAILURE without a page
+ */
+int run_simtop(const char *name, int interval)
+{
+   if(interval <= 0)
+      interval = SIMTOP_INTERVAL;
+
+   int fd = shm_open(name, O_RDONLY, 0);
+   void *address = fd == -1 ? MAP_FAILED :
+                   mmap(NULL, sizeof(metrics_page), PROT_READ, MAP_SHARED, fd, 0);
+   if(fd != -1)
+      close(fd);
+   const metrics_page *page = (const metrics_page *)address;
+   if(address == MAP_FAILED || page->version.load() != METRICS_VERSION)
+   {
+      cout << "ERROR: No metrics page named " << name << endl;
+      return FILE_PARSE_FAILURE;
+   }
+
+   bool terminal = isatty(STDOUT_FILENO);
+   metrics_sample previous, sample;
+   while(!readMetrics(page, previous))
+      ;
+
+   while(true)
+   {
+      struct timespec delay = { interval / 1000, (interval % 1000) * 1000000L };
+      nanosleep(&delay, NULL);
+      while(!readMetrics(page, sample))
+         ;
+
+      // A killed processor never publishes its exit
+      bool killed = !sample.exited && kill(sample.processorPid, 0) == -1 && errno == ESRCH;
+
+      double seconds = (sample.publishTime - previous.publishTime) / 1e9;
+      double instructionRate = seconds > 0 ? (sample.instructions - previous.instructions) / seconds : 0;
+      double requestRate = seconds > 0 ? (sample.memoryRequests - previous.memoryRequests) / seconds : 0;
+      double interruptRate = seconds > 0 ? (sample.interrupts - previous.interrupts) / seconds : 0;
+
+      stringstream screen;
+      screen << fixed << setprecision(0);
+      screen << "simtop " << name << " - up " << setprecision(1)
+             << (sample.publishTime - sample.startTime) / 1e9 << " s"
+	     << (sample.exited ? string(", exited ") + exit_code_name(sample.exitCode) : string(""))
+	     << (killed ? ", processor killed" : "")
+	     << setprecision(0) << endl;
+      screen << "  Instructions:    " << setw(12) << sample.instructions
+             << "  " << setw(10) << instructionRate << " /s" << endl;
+      screen << "  Memory requests: " << setw(12) << sample.memoryRequests
+             << "  " << setw(10) << requestRate << " /s" << endl;
+      screen << "  Interrupts:      " << setw(12) << sample.interrupts
+             << "  " << setw(10) << interruptRate << " /s" << endl;
+      screen << "  PC:              " << setw(12) << sample.pc
+             << "  " << (sample.kernelMode ? "kernel" : "user") << " mode" << endl;
+      screen << "  Processor:       " << setw(12) << sample.processorPid
+             << "  " << schedulerState(sample.processorPid) << endl;
+      screen << "  Main memory:     " << setw(12) << sample.memoryPid
+             << "  " << schedulerState(sample.memoryPid) << endl;
+
+      // Redraw in place on a terminal
+      if(terminal)
+         cout << "\033[H\033[2J";
+      cout << screen.str() << endl;
+
+      if(sample.exited || killed)
+         break;
+      previous = sample;
+   }
+
+   munmap(address, sizeof(metrics_page));
+   return SUCCESS;
+}
+
+/* Read Metrics
+ * Copies the page under the sequence lock.
+ *
+ * <page> metrics page
+ * <sample> copy of the page
+ * <return> false if a publish raced the copy
+ */
+bool readMetrics(const metrics_page *page, metrics_sample &sample)
+{
+   unsigned int sequence = page->sequence.load(memory_order_acquire);
+   if(sequence & 1)
+      return false;
+
+   sample.processorPid = page->processorPid.load(memory_order_relaxed);
+   sample.memoryPid = page->memoryPid.load(memory_order_relaxed);
+   sample.startTime = page->startTime.load(memory_order_relaxed);
+   sample.publishTime = page->publishTime.load(memory_order_relaxed);
+   sample.instructions = page->instructions.load(memory_order_relaxed);
+   sample.memoryRequests = page->memoryRequests.load(memory_order_relaxed);
+   sample.interrupts = page->interrupts.load(memory_order_relaxed);
+   sample.pc = page->pc.load(memory_order_relaxed);
+   sample.kernelMode = page->kernelMode.load(memory_order_relaxed);
+   sample.exited = page->exited.load(memory_order_relaxed);
+   sample.exitCode = page->exitCode.load(memory_order_relaxed);
+
+   atomic_thread_fence(memory_order_acquire);
+   return page->sequence.load(memory_order_relaxed) == sequence;
+}
+
+/* Scheduler State
+ * <pid> process id
+ * <return> scheduler state, CPU and context switches from /proc
+ */
+string schedulerState(int pid)
+{
+   stringstream path;
+   path << "/proc/" << pid << "/stat";
+   ifstream stat(path.str().c_str());
+   string line;
+   if(!getline(stat, line) || line.rfind(')') == string::npos)
+      return "gone";
+
+   // Fields after the command name: state is field 3,
+   // last CPU is field 39
+   stringstream fields(line.substr(line.rfind(')') + 2));
+   string field, state;
+   int cpu = -1;
+   for(int number = 3; fields >> field; number++)
+   {
+      if(number == 3)
+         state = field;
+      else if(number == 39)
+         cpu = stoi(field);
+   }
+
+   // Context switch counts
+   stringstream statusPath;
+   statusPath << "/proc/" << pid << "/status";
+   ifstream status(statusPath.str().c_str());
+   long long voluntary = 0, involuntary = 0;
+   while(getline(status, line))
+   {
+      if(line.compare(0, 24, "voluntary_ctxt_switches:") == 0)
+         voluntary = stoll(line.substr(24));
+      else if(line.compare(0, 27, "nonvoluntary_ctxt_switches:") == 0)
+         involuntary = stoll(line.substr(27));
+   }
+
+   stringstream text;
+   text << "state " << state << ", CPU " << cpu << ", "
+        << voluntary << " voluntary / " << involuntary << " involuntary switches";
+   return text.str();
+}
+
+/* Monotonic Nanos
+ * <return> CLOCK_MONOTONIC time in nanoseconds
+ */
+long long monotonic_nanos()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
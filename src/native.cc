@@ -0,0 +1,89 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Native Handlers
+//   Implementation below is executed by the processor process.
+//   An interrupt vector (timer, input or system call) may be
+//   served by a host function instead of the handler in
+//   simulated memory.  The processor then skips pushing the
+//   registers through main memory and interpreting the
+//   handler: the host function gets the saved registers and
+//   memory accessors, and on return the registers are
+//   restored as IRet would.  Vectors without a native handler
+//   run the simulated one.
+
+#include <iostream>
+#include "program.h"
+using namespace std;
+
+// Native handler of each vector (NULL = simulated)
+native_handler native_handlers[VECTOR_COUNT];
+
+/* Register Native Handler
+ * <vector> SYS_INDEX, INPUT_INDEX or INT_INDEX
+ * <handler> host handler, or NULL for the simulated one
+ * <return> false if the address is not an interrupt vector
+ */
+bool register_native_handler(int vector, native_handler handler)
+{
+   int slot = simos::vector_slot(vector);
+   if(slot == -1)
+      return false;
+   native_handlers[slot] = handler;
+   return true;
+}
+
+/* Native Handler At
+ * <vector> interrupt handler address
+ * <return> native handler of the vector, or NULL
+ */
+native_handler native_handler_at(int vector)
+{
+   int slot = simos::vector_slot(vector);
+   return slot == -1 ? NULL : native_handlers[slot];
+}
+
+/* Native Return
+ * Built-in handler that returns at once, the native form of
+ * a handler made of a lone IRet.
+ *
+ * <frame> saved registers, left unchanged
+ */
+void native_return(interrupt_frame &frame)
+{
+}
+
+/* Check Native Return
+ * native_return only stands in for a handler that is a lone
+ * IRet, so any other handler at the vector refuses it.
+ *
+ * <vector> interrupt handler address
+ * <handler> word of the program image at the vector
+ * <return> false, after printing why, for any other handler
+ */
+bool check_native_return(int vector, long long handler)
+{
+   if(handler == SYSRETURN)
+      return true;
+   cout << "ERROR: --native " << vector << " needs a lone IRet (" << SYSRETURN
+        << ") at the vector, the program has " << handler << endl << endl;
+   return false;
+}
@@ -0,0 +1,394 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Process Placement
+//   Implementation below is executed by both processes.  Pins
+//   the processor and main memory processes to chosen CPUs,
+//   or to the pair of CPUs with the lowest round trip found
+//   by a probe run before main memory is forked.  Also holds
+//   the busy-poll service mode, where main memory spins on
+//   its request pipe instead of waiting for SIGINT.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include "program.h"
+using namespace std;
+
+// Round trips timed per candidate pair, and most cores probed
+#define PROBE_ROUNDS 500
+#define PROBE_WARMUP 50
+#define MAX_PROBE_CORES 8
+
+// Methods
+bool   pinCpu(int cpu);
+double probeRoundTrip(int processorCpu, int memoryCpu);
+void   probeResponder(int requests, int replies);
+void   probeEcho(int signum);
+int    cpuTopology(int cpu, const char *field);
+string cpuRelation(int first, int second);
+
+// CPUs to pin to (-1 = not pinned)
+int processor_cpu = -1;
+int memory_cpu = -1;
+
+// Placement probe flag and the best round trip found (us)
+bool auto_placement = false;
+double probe_round_trip = -1;
+
+// Busy-poll service mode flag
+bool busy_poll = false;
+
+// Pipes of the probe responder, for its SIGINT handler
+int probe_requests = -1;
+int probe_replies = -1;
+
+/* Set CPU Pinning
+ * <processorCpu> CPU for the processor process
+ * <memoryCpu> CPU for the main memory process
+ */
+void set_cpu_pinning(int processorCpu, int memoryCpu)
+{
+   processor_cpu = processorCpu;
+   memory_cpu = memoryCpu;
+}
+
+/* Set Auto Placement
+ * <enabled> probe for the best pair of CPUs
+ */
+void set_auto_placement(bool enabled)
+{
+   auto_placement = enabled;
+}
+
+/* Set Busy Poll
+ * <enabled> main memory spins on its request pipe
+ */
+void set_busy_poll(bool enabled)
+{
+   busy_poll = enabled;
+}
+
+/* Notify Memory
+ * Wakes main memory for a request written to its pipe.
+ * In busy-poll mode main memory is already watching.
+ *
+ * <memoryPid> main memory process id
+ */
+void notify_memory(int memoryPid)
+{
+   if(!busy_poll)
+      kill(memoryPid, SIGINT);
+}
+
+/* Wait For Request
+ * Main memory side: returns once a request is waiting on
+ * the pipe, spinning in busy-poll mode and otherwise
+ * leaving it to the SIGINT handler.
+ *
+ * <fd> request pipe
+ * <return> true if a request is waiting to be served
+ */
+bool wait_for_request(int fd)
+{
+   if(!busy_poll)
+   {
+      pause();
+      return false;
+   }
+
+   int ready = 0;
+   while(ioctl(fd, FIONREAD, &ready) == 0 && ready == 0)
+      ;
+   return ready > 0;
+}
+
+/* Choose Placement
+ * Runs the placement probe when enabled.  The candidates are
+ * one allowed CPU per core, plus the SMT sibling of each; the
+ * probe times round trips between every pair of cores (a core
+ * with itself included) and between each core and its
+ * sibling, and keeps the fastest pair.  Called before main
+ * memory is forked.
+ */
+void choose_placement()
+{
+   if(!auto_placement)
+      return;
+
+   cpu_set_t allowed;
+   if(sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+      return;
+
+   // A responder that fails to pin must not kill the processor
+   void (*pipeHandler)(int) = signal(SIGPIPE, SIG_IGN);
+
+   // First CPU of each core and its first SMT sibling (-1 =
+   // none).  CPUs of unknown topology count as cores.
+   vector<int> cores, siblings, coreIds, packages;
+   for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+   {
+      if(!CPU_ISSET(cpu, &allowed))
+         continue;
+      int package = cpuTopology(cpu, "physical_package_id");
+      int core = cpuTopology(cpu, "core_id");
+      size_t i = 0;
+      while(i < cores.size() && (core < 0 || coreIds[i] != core || packages[i] != package))
+         i++;
+      if(i < cores.size())
+      {
+         if(siblings[i] == -1)
+            siblings[i] = cpu;
+      }
+      else if((int)cores.size() < MAX_PROBE_CORES)
+      {
+         cores.push_back(cpu);
+         siblings.push_back(-1);
+         coreIds.push_back(core);
+         packages.push_back(package);
+      }
+   }
+
+   vector<pair<int, int> > candidates;
+   for(size_t i = 0; i < cores.size(); i++)
+   {
+      for(size_t j = i; j < cores.size(); j++)
+         candidates.push_back(make_pair(cores[i], cores[j]));
+      if(siblings[i] != -1)
+         candidates.push_back(make_pair(cores[i], siblings[i]));
+   }
+
+   for(size_t i = 0; i < candidates.size(); i++)
+   {
+      double roundTrip = probeRoundTrip(candidates[i].first, candidates[i].second);
+      if(roundTrip >= 0 && (probe_round_trip < 0 || roundTrip < probe_round_trip))
+      {
+         probe_round_trip = roundTrip;
+	 set_cpu_pinning(candidates[i].first, candidates[i].second);
+      }
+   }
+
+   // Leave the processor free to be pinned for the run
+   sched_setaffinity(0, sizeof(allowed), &allowed);
+   signal(SIGPIPE, pipeHandler);
+}
+
+/* Pin Processor
+ * Pins the calling (processor) process to its CPU.
+ */
+void pin_processor()
+{
+   if(processor_cpu >= 0 && !pinCpu(processor_cpu))
+   {
+      cerr << "Failed to pin processor to CPU " << processor_cpu << endl;
+      processor_cpu = -1;
+   }
+}
+
+/* Pin Memory
+ * Pins the calling (main memory) process to its CPU.
+ */
+void pin_memory()
+{
+   if(memory_cpu >= 0 && !pinCpu(memory_cpu))
+      cerr << "Failed to pin main memory to CPU " << memory_cpu << endl;
+}
+
+/* Describe Placement
+ * <return> CPUs, their topology relation and service mode
+ */
+string describe_placement()
+{
+   stringstream text;
+   if(processor_cpu < 0 && memory_cpu < 0)
+      text << "not pinned";
+   else
+   {
+      text << "processor ";
+      if(processor_cpu >= 0)
+         text << "CPU " << processor_cpu;
+      else
+         text << "not pinned";
+      text << ", memory CPU " << memory_cpu;
+      if(processor_cpu >= 0)
+         text << " (" << cpuRelation(processor_cpu, memory_cpu) << ")";
+   }
+   text << ", " << (busy_poll ? "busy-poll" : "signal") << " service";
+   if(probe_round_trip >= 0)
+      text << ", probed round trip " << probe_round_trip << " us";
+   return text.str();
+}
+
+/* Pin CPU
+ * <cpu> CPU to run the calling process on
+ * <return> false if the affinity could not be set
+ */
+bool pinCpu(int cpu)
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+/* Probe Round Trip
+ * Forks a responder on one CPU and times round trips from
+ * the other through notify_memory and wait_for_request, the
+ * transport of the run in either service mode.
+ *
+ * <processorCpu> CPU of the requesting side
+ * <memoryCpu> CPU of the responding side
+ * <return> mean round trip in microseconds, -1 on failure
+ */
+double probeRoundTrip(int processorCpu, int memoryCpu)
+{
+   int requests[2], replies[2];
+   if(pipe(requests) == -1)
+      return -1;
+   if(pipe(replies) == -1)
+   {
+      close(requests[0]);
+      close(requests[1]);
+      return -1;
+   }
+
+   int pid = fork();
+   if(pid == 0)
+   {
+      close(requests[1]);
+      close(replies[0]);
+      if(!pinCpu(memoryCpu))
+         _exit(1);
+      probeResponder(requests[0], replies[1]);
+   }
+
+   // A responder that exits shows up as a failed read.  It
+   // writes once when it is ready for SIGINT.
+   close(requests[0]);
+   close(replies[1]);
+
+   double roundTrip = -1;
+   int value = 0;
+   if(pid > 0 && pinCpu(processorCpu) &&
+      read(replies[0], &value, sizeof(int)) == sizeof(int))
+   {
+      long long start = 0;
+      bool ok = true;
+      for(int i = 0; ok && i < PROBE_WARMUP + PROBE_ROUNDS; i++)
+      {
+         if(i == PROBE_WARMUP)
+	    start = monotonic_nanos();
+	 ok = write(requests[1], &i, sizeof(int)) == sizeof(int);
+	 notify_memory(pid);
+	 ok = ok && read(replies[0], &value, sizeof(int)) == sizeof(int);
+      }
+      if(ok)
+         roundTrip = (monotonic_nanos() - start) / 1e3 / PROBE_ROUNDS;
+   }
+
+   close(requests[1]);
+   close(replies[0]);
+   if(pid > 0)
+   {
+      kill(pid, SIGKILL);
+      waitpid(pid, NULL, 0);
+   }
+   return roundTrip;
+}
+
+/* Probe Responder
+ * Child side of the probe: serves requests as main memory
+ * does, from the SIGINT handler or after a busy poll.
+ *
+ * <requests> request pipe to read
+ * <replies> reply pipe to write
+ */
+void probeResponder(int requests, int replies)
+{
+   probe_requests = requests;
+   probe_replies = replies;
+   signal(SIGINT, probeEcho);
+
+   int ready = 0;
+   write(replies, &ready, sizeof(int));
+   while(true)
+      if(wait_for_request(requests))
+         probeEcho(SIGINT);
+}
+
+/* Probe Echo
+ * Echoes one request of the probe.
+ *
+ * <signum> signal received (SIGINT)
+ */
+void probeEcho(int signum)
+{
+   int value;
+   if(read(probe_requests, &value, sizeof(int)) != sizeof(int))
+      _exit(0);
+   write(probe_replies, &value, sizeof(int));
+}
+
+/* CPU Topology
+ * <cpu> CPU number
+ * <field> topology file, e.g. core_id
+ * <return> value of the field, -1 if unknown
+ */
+int cpuTopology(int cpu, const char *field)
+{
+   stringstream path;
+   path << "/sys/devices/system/cpu/cpu" << cpu << "/topology/" << field;
+   ifstream file(path.str().c_str());
+   int value = -1;
+   if(!(file >> value))
+      return -1;
+   return value;
+}
+
+/* CPU Relation
+ * <first> first CPU
+ * <second> second CPU
+ * <return> how the CPUs share hardware
+ */
+string cpuRelation(int first, int second)
+{
+   if(first == second)
+      return "same CPU";
+
+   int firstPackage = cpuTopology(first, "physical_package_id");
+   int secondPackage = cpuTopology(second, "physical_package_id");
+   int firstCore = cpuTopology(first, "core_id");
+   int secondCore = cpuTopology(second, "core_id");
+   if(firstPackage < 0 || secondPackage < 0)
+      return "topology unknown";
+   if(firstPackage != secondPackage)
+      return "different packages";
+   if(firstCore >= 0 && firstCore == secondCore)
+      return "SMT siblings";
+   return "same package";
+}
@@ -36,26 +36,30 @@
 #include <exception>
 #include <stdexcept>
 #include "program.h"
+#include "execute.h"
+#include "tracepoints.h"
 using namespace std;
 
 // Methods
 void fetchInstruction();
-void executeInstruction();
+int  fetchOperand();
+int  readStream(int address, bool proven);
 void run_execution_cycle();
 void verifyAccess(int address);
 void endProcess(int errorCode);
 int  readMemory(int address);
 void writeMemory(int address, int value);
+int  readMemoryUnchecked(int address);
+void writeMemoryUnchecked(int address, int value);
+int  readPort(int port);
+void writePort(int port, int value);
 void syscall(int address);
 void return_syscall();
+void runNativeHandler(native_handler handler, int address);
 void checkInterrupt();
 void setTimer(int argc, char *argv[]);
-void pushRegistersOnStack();
-void popRegistersOnStack();
 void debugProgram();
 void printRegistersAndStack();
-void pushStack(int value);
-int  popStack();
 
 // Timer, counters, and inactive stack values
 int interrupt_timer;
@@ -65,6 +69,15 @@ int inactive_sys_stack, inactive_proc_stack;
 // Registers
 int registers[REGCOUNT];
 
+// Address of the executing instruction and whether the next
+// fetch was proven in bounds by the static analysis
+int instruction_address;
+bool fetch_proven = false;
+
+// Main memory requests sent and interrupts taken
+long long memory_requests = 0;
+long long interrupts_taken = 0;
+
 // Process Ids
 int *process;
 
@@ -76,6 +89,39 @@ int *readFromMem;
 bool interruptEnabledFlag;
 bool kernelMode;
 
+// Execute core policy of the processor: main memory through
+// the pipes, skipping verifyAccess where the static analysis
+// proved the operand target in bounds
+struct processor_cpu
+{
+   typedef int word;
+   int *registers;
+
+   int  fetch_operand() { return fetchOperand(); }
+   int  fetch_target() { return readStream(registers[PC], false); }
+   int  read(int address) { return readMemory(address); }
+   void write(int address, int value) { writeMemory(address, value); }
+   int  read_target(int address)
+   {
+      if(site_flags_at(instruction_address) & TARGET_SAFE)
+         return readMemoryUnchecked(address);
+      return readMemory(address);
+   }
+   void write_target(int address, int value)
+   {
+      if(site_flags_at(instruction_address) & TARGET_SAFE)
+         writeMemoryUnchecked(address, value);
+      else
+         writeMemory(address, value);
+   }
+   int  read_port(int port) { return readPort(port); }
+   void write_port(int port, int value) { writePort(port, value); }
+   void syscall(int address) { ::syscall(address); }
+   void return_syscall() { ::return_syscall(); }
+   void end(int exitCode) { endProcess(exitCode); }
+};
+processor_cpu cpu = { registers };
+
 /* Run Processor
  * Main processor routine which executes once the main memory has initialized.
  * Declares and initializes all variables needed by the process.
@@ -107,6 +153,14 @@ void run_processor(int timer, int *pid, int wToMem[], int rFromMem[], bool debug
    interruptEnabledFlag = true;
    kernelMode = false;
 
+   // Map the built-in devices
+   register_builtin_devices();
+
+   // Time the run from here
+   start_stats();
+   start_metrics();
+   start_profile();
+
    // Run debug output or run execution loop
    if(debugMode)
       debugProgram();
@@ -120,73 +174,36 @@ void run_processor(int timer, int *pid, int wToMem[], int rFromMem[], bool debug
 /* Run Execution Cycle
  * Fetch instruction, increment program counter,
  * execute instruction, increment instruction counter,
- * and check for interrupts.  Repeat.
+ * and check for interrupts.  Repeat.  Taken backward
+ * branches may fast-forward arithmetic-only loops.
+ * Fetches proven by the static analysis skip verifyAccess.
  */
 void run_execution_cycle()
 {
    while(true)
    {
+      int address = instruction_address = registers[PC];
       fetchInstruction();
       registers[PC]++;
-      executeInstruction();
+      execute_instruction(cpu);
       instruction_counter++;
+      retire_instruction(address);
+      stats_retire(address);
+      profile_retire(address, registers[IR]);
+      TRACE_PROBE2(instruction_retire, address, registers[IR]);
+      tick_framebuffer(instruction_counter);
+      tick_metrics(instruction_counter);
       checkInterrupt();
-   }
-}
 
-/* Push Stack
- * Pushes a value onto the stack
- *
- * <value> value to push onto stack
- */
-void pushStack(int value)
-{
-   writeMemory(--registers[SP], value);
-}
-
-/* Pop Stack
- * Pop a value form the stack
- *
- * <return> value popped from stack
- */
-int popStack()
-{
-   return readMemory(registers[SP]++);
-}
-
-/* Push Registers on Stack
- * Push all registers excluding the SP register onto the stack
- */
-void pushRegistersOnStack()
-{
-   // For each register except the last one (SP)
-   for(int i=1; i < REGCOUNT; i++)
-   {
-      // Write it to the stack at offset below stack pointer
-      writeMemory(registers[SP]-i, registers[i-1]);
-   }
-
-   // Update the stack pointer
-   registers[SP] -= (REGCOUNT-1);
-}
+      // Try to skip the rest of a loop after a backward branch
+      if(registers[IR] == JUMP_IF_NEQ && registers[PC] <= address)
+         fast_forward_loop(address);
 
-/* Pop Registers on Stack
- * Pop all registers excluding the SP register off the stack
- */
-void popRegistersOnStack()
-{
-   // For each register execpt the last one (SP)
-   for(int i=1; i < REGCOUNT; i++)
-   {
-      // Pop it off the stack onto the register
-      registers[i-1] = readMemory(registers[SP]+REGCOUNT-1-i);
+      // Static successors (and interrupt vectors) are in bounds
+      fetch_proven = site_flags_at(address) & NEXT_SAFE;
    }
-
-   // Update the stack pointer
-   registers[SP] += (REGCOUNT-1);
 }
 
-
 /* Verify Access
  * Check if address is valid and if the mode allows
  * access to that memory space.  Restrict access
@@ -222,19 +239,44 @@ void verifyAccess(int address)
  */
 int readMemory(int address)
 {
+   // Memory-mapped devices are accessible in either mode,
+   // except for their kernel registers
+   if(device *dev = find_device(address))
+   {
+      if(!kernelMode && kernel_register(*dev, address))
+         endProcess(KERNEL_MEM_ACCESS_DENIED);
+      int value;
+      if(!dev->read(address - dev->base, &value))
+         endProcess(INVALID_PORT_CALL);
+      return value;
+   }
+
    // Verify permissions and valid address
    verifyAccess(address);
-   
+   return readMemoryUnchecked(address);
+}
+
+/* Read Memory Unchecked
+ * Fetch value from main memory without verifying access.
+ * Only for addresses proven in bounds for the current mode.
+ *
+ * <address> address to fetch value from
+ */
+int readMemoryUnchecked(int address)
+{
    // Write I/O operation and address to pipe
    // Send the SIGINT to execute the call
    int action = READ;
+   TRACE_PROBE2(memory_request, action, address);
    write(writeToMem[1], &action, sizeof(int));
    write(writeToMem[1], &address, sizeof(int));
-   kill(process[MAIN_MEMORY], SIGINT);
+   notify_memory(process[MAIN_MEMORY]);
+   memory_requests++;
    
    // Verify if successful
    int status;
    read(readFromMem[0], &status, sizeof(int));
+   TRACE_PROBE3(memory_reply, action, address, status);
    if(status != SUCCESS)
    {
       endProcess(status);
@@ -246,6 +288,48 @@ int readMemory(int address)
    
 }
 
+/* Memory Digest
+ * Request the root of the main memory hash tree.
+ *
+ * <return> digest of the main memory state
+ */
+uint64_t memory_digest()
+{
+   int request[2] = { DIGEST, 0 };
+   uint64_t digest = 0;
+   write(writeToMem[1], request, sizeof(request));
+   notify_memory(process[MAIN_MEMORY]);
+   memory_requests++;
+   read(readFromMem[0], &digest, sizeof(digest));
+   return digest;
+}
+
+/* Dump Memory
+ * Request the whole main memory image at once.
+ *
+ * <image> array of MEMORY_SIZE words to fill
+ * <return> false if the image could not be read
+ */
+bool dump_memory(int image[])
+{
+   int request[2] = { DUMP, 0 };
+   write(writeToMem[1], request, sizeof(request));
+   notify_memory(process[MAIN_MEMORY]);
+   memory_requests++;
+
+   char *position = (char *)image;
+   size_t size = MEMORY_SIZE * sizeof(int);
+   while(size > 0)
+   {
+      ssize_t count = read(readFromMem[0], position, size);
+      if(count <= 0)
+         return false;
+      position += count;
+      size -= count;
+   }
+   return true;
+}
+
 /* Write Memory
  * Write value to address in main memory.
  *
@@ -254,34 +338,101 @@ int readMemory(int address)
  */
 void writeMemory(int address, int value)
 {
+   // Memory-mapped devices are accessible in either mode,
+   // except for their kernel registers
+   if(device *dev = find_device(address))
+   {
+      if(!kernelMode && kernel_register(*dev, address))
+         endProcess(KERNEL_MEM_ACCESS_DENIED);
+      if(!dev->write(address - dev->base, value))
+         endProcess(INVALID_PORT_CALL);
+      return;
+   }
+
    // Verify permissions and valid address
    verifyAccess(address);
+   writeMemoryUnchecked(address, value);
+}
+
+/* Write Memory Unchecked
+ * Write value to address in main memory without verifying
+ * access.  Only for addresses proven in bounds for the
+ * current mode.
+ *
+ * <address> address to write value to
+ * <value> value to write
+ */
+void writeMemoryUnchecked(int address, int value)
+{
+   // Stores into fetched code invalidate the copy and proofs
+   invalidate_code_word(address);
+   invalidate_site(address);
 
    // Write I/O operation, address, and value to pipe
    // Send the SIGINT to execute the call
    int action = WRITE;
+   TRACE_PROBE2(memory_request, action, address);
    write(writeToMem[1], &action, sizeof(int));
    write(writeToMem[1], &address, sizeof(int));
    write(writeToMem[1], &value, sizeof(int));
-   kill(process[MAIN_MEMORY], SIGINT);
+   notify_memory(process[MAIN_MEMORY]);
+   memory_requests++;
 
    // Verify if successful
    int status;
    read(readFromMem[0], &status, sizeof(int));
+   TRACE_PROBE3(memory_reply, action, address, status);
    if(status != SUCCESS)
    {
       endProcess(status);      
    }
+
+   // Words fetched ahead at the address are now stale
+   squash_fetch_on_store(address);
+}
+
+/* Read Port
+ * Read a device register for the IN instruction.  Ports
+ * are offsets into the I/O region.
+ *
+ * <port> port value
+ * <return> value read from the device
+ */
+int readPort(int port)
+{
+   int address = IO_BASE + port;
+   if(port < 0 || find_device(address) == NULL)
+      endProcess(INVALID_PORT_CALL);
+   return readMemory(address);
+}
+
+/* Write Port
+ * Write a device register for the PUT instruction.  Ports
+ * are offsets into the I/O region.
+ *
+ * <port> port value
+ * <value> value to write
+ */
+void writePort(int port, int value)
+{
+   int address = IO_BASE + port;
+   if(port < 0 || find_device(address) == NULL)
+      endProcess(INVALID_PORT_CALL);
+   writeMemory(address, value);
 }
 
 /* Check interrupt
  * Make syscall for timeout if instruction counter
- * exceeds the interrupt timer set.
+ * exceeds the interrupt timer set.  Otherwise, deliver
+ * an armed input readiness interrupt once input is ready.
  */
 void checkInterrupt()
 {
    if(instruction_counter % interrupt_timer == 0)
       syscall(SYS_INDEX);
+   // Input readiness interrupt waits until it can be taken
+   else if(interruptEnabledFlag && !kernelMode && take_input_interrupt())
+      syscall(INPUT_INDEX);
 }
 
 /* System Call
@@ -300,7 +451,15 @@ void syscall(int address)
       // If not kernel mode, mode switch
       if(!kernelMode)
       {
+         // A native handler runs on the host instead
+         if(native_handler handler = native_handler_at(address))
+         {
+            runNativeHandler(handler, address);
+            return;
+         }
+
          // Mode switch
+         stats_interrupt_entry(address);
          kernelMode = true;
 	 //Disable recursive interrupts
          interruptEnabledFlag = false;
@@ -308,8 +467,11 @@ void syscall(int address)
 	 inactive_proc_stack = registers[SP]; 
 	 registers[SP] = inactive_sys_stack;
 	 // Push registers onto stack
-         pushRegistersOnStack();
+         push_registers(cpu);
+         stats_handler_start();
 	 // Execute interrupt handler
+	 TRACE_PROBE2(interrupt_entry, address, registers[PC]);
+	 interrupts_taken++;
          registers[PC] = address;
       }
       else
@@ -325,13 +487,53 @@ void syscall(int address)
 void return_syscall()
 {
    // Pop register values from stack
-   popRegistersOnStack();
+   stats_interrupt_exit();
+   pop_registers(cpu);
    // Switch stack pointers
    inactive_sys_stack = registers[SP];
    registers[SP] = inactive_proc_stack;
    // Enable interrupts and mode switch to user mode
    interruptEnabledFlag = true;
    kernelMode = false;
+   stats_return_to_user();
+   TRACE_PROBE1(interrupt_exit, registers[PC]);
+}
+
+/* Run Native Handler
+ * Takes an interrupt with a host handler: the registers are
+ * saved in a host frame rather than on the system stack, the
+ * handler runs in kernel mode with interrupts disabled, and
+ * the frame is restored as IRet would.  The handler retires
+ * no simulated instructions.
+ *
+ * <handler> host handler of the vector
+ * <address> interrupt handler address
+ */
+void runNativeHandler(native_handler handler, int address)
+{
+   interrupt_frame frame;
+   frame.vector = address;
+   for(int i = 0; i < REGCOUNT; i++)
+      frame.registers[i] = registers[i];
+   frame.read = readMemory;
+   frame.write = writeMemory;
+
+   TRACE_PROBE2(interrupt_entry, address, registers[PC]);
+   interrupts_taken++;
+   stats_interrupt_entry(address);
+   kernelMode = true;
+   interruptEnabledFlag = false;
+   stats_handler_start();
+
+   handler(frame);
+
+   stats_interrupt_exit();
+   for(int i = 0; i < REGCOUNT; i++)
+      registers[i] = frame.registers[i];
+   interruptEnabledFlag = true;
+   kernelMode = false;
+   stats_return_to_user();
+   TRACE_PROBE1(interrupt_exit, registers[PC]);
 }
 
 /* End Process
@@ -342,207 +544,107 @@ void return_syscall()
  */
 void endProcess(int exitCode)
 {
+   TRACE_PROBE2(process_exit, exitCode, instruction_counter);
+
+   // Report the run statistics and save the final state
+   // while main memory can still answer
+   print_stats();
+   write_checkpoint(exitCode);
+   write_core_dump(exitCode);
+   finish_metrics(exitCode);
+   write_profile();
+
    // Terminate the main memory process
    kill(process[MAIN_MEMORY], SIGKILL);
+
+   // Show the final framebuffer contents
+   render_framebuffer();
    
    // Print the exit status
-   cout << "EXIT CODE: ";
-   switch(exitCode)
-   {
-      case SUCCESS: cout << "SUCCESS"; break;
-      case CLI_FAILURE: cout << "CLI FAILURE"; break;
-      case FORK_FAILURE: cout << "FORK FAILURE"; break;
-      case PIPE_FAILURE: cout << "PIPE FAILURE"; break;
-      case FILE_PARSE_FAILURE: cout << "FILE PARSE FAILURE"; break;
-      case INVALID_OPCODE: cout << "INVALID OPCODE"; break;
-      case PROGRAM_PATH_FAILURE: cout << "PROGRAM PATH FAILURE"; break;
-      case READ_FAILURE: cout << "READ FAILURE"; break;
-      case WRITE_FAILURE: cout << "WRITE FAILURE"; break;
-      case INVALID_MEM_ACTION: cout << "INVALID MEM ACTION"; break;
-      case MEMORY_OUT_OF_BOUNDS: cout << "MEMORY OUT OF BOUNDS"; break;
-      case KERNEL_MEM_ACCESS_DENIED: cout << "KERNEL_MEM_ACCESS_DENIED"; break;
-      case USER_MEM_ACCESS_DENIED: cout << "USER_MEM_ACCESS_DENIED"; break;
-      case INVALID_PORT_CALL: cout << "INVALID PORT CALL"; break;
-      default: cout << "MISSING EXIT CODE"; break;
-   }
-   
-   cout << endl << endl;
+   cout << "EXIT CODE: " << exit_code_name(exitCode) << endl << endl;
+
+   // Report back to the client of a zygote job
+   finish_job(exitCode);
  
    // Return exit status value and end program
    exit(exitCode);
 }
 
+/* Exit Code Name
+ * <exitCode> Exit status value
+ * <return> printable name of the exit status
+ */
+const char *exit_code_name(int exitCode)
+{
+   switch(exitCode)
+   {
+      case SUCCESS: return "SUCCESS";
+      case CLI_FAILURE: return "CLI FAILURE";
+      case FORK_FAILURE: return "FORK FAILURE";
+      case PIPE_FAILURE: return "PIPE FAILURE";
+      case FILE_PARSE_FAILURE: return "FILE PARSE FAILURE";
+      case INVALID_OPCODE: return "INVALID OPCODE";
+      case PROGRAM_PATH_FAILURE: return "PROGRAM PATH FAILURE";
+      case READ_FAILURE: return "READ FAILURE";
+      case WRITE_FAILURE: return "WRITE FAILURE";
+      case INVALID_MEM_ACTION: return "INVALID MEM ACTION";
+      case MEMORY_OUT_OF_BOUNDS: return "MEMORY OUT OF BOUNDS";
+      case KERNEL_MEM_ACCESS_DENIED: return "KERNEL_MEM_ACCESS_DENIED";
+      case USER_MEM_ACCESS_DENIED: return "USER_MEM_ACCESS_DENIED";
+      case INVALID_PORT_CALL: return "INVALID PORT CALL";
+      case INPUT_FAILURE: return "INPUT FAILURE";
+      case DISK_FAILURE: return "DISK FAILURE";
+      case MEMORY_ALLOC_FAILURE: return "MEMORY ALLOC FAILURE";
+      default: return "MISSING EXIT CODE";
+   }
+}
+
 /* Fetch Instruction
  * Simply read the next instruction from main memory based on PC register
  * and store in IR register.
  */
 void fetchInstruction()
 {
-   registers[IR] = readMemory(registers[PC]);
+   registers[IR] = readStream(registers[PC], fetch_proven);
+   record_code_word(registers[PC], registers[IR]);
 }
 
-/* Execute Instruction
- * Decode the value in IR register using switch statement.
- * Execute based on case.
+/* Fetch Operand
+ * Read the operand at the PC register and advance the PC.
+ * Skips verifyAccess when the operand fetch is proven.
+ *
+ * <return> operand value
  */
-void executeInstruction()
+int fetchOperand()
 {
-      int temp; // Temp value for instruction execution
+   int value = readStream(registers[PC], site_flags_at(instruction_address) & OPERAND_SAFE);
+   record_code_word(registers[PC], value);
+   registers[PC]++;
+   return value;
+}
 
-      // Decode instruction in IR register
-      switch(registers[IR])
-      {
-         case  LOAD_VAL:      
-	         // Load value on next line into AC register
-                 registers[AC] = readMemory(registers[PC]++);
-	         break;
-	 case  LOAD_ADDR: 
-	         // Load value at address into AC register
-	         temp = readMemory(registers[PC]++);
-		 registers[AC] = readMemory(temp);
-	 	 break;
-	 case  LOAD_IND_ADDR: 
-	         // Load value from address found in given address into AC register
-		 temp = readMemory(registers[PC]++);
-		 temp = readMemory(temp);
-		 registers[AC] = readMemory(temp);
-	 	 break;
-	 case  LOAD_IDX_X_ADDR: 
-	         // Load Idx X Addr: Load value at address + offset X into AC register
-	 	 temp = readMemory(registers[PC]++);
-		 registers[AC] = readMemory(temp + registers[X]);
-	 	 break;
-	 case  LOAD_IDX_Y_ADDR: 
-	         // Load Idx Y Addr: Load value at 
-	 	 temp = readMemory(registers[PC]++);
-		 registers[AC] = readMemory(temp + registers[Y]);
-	 	 break;
-	 case  LOAD_SPX: 
-	         // Load SP + X into AC 
-		 registers[AC] = readMemory(registers[SP] + registers[X]);
-	 	 break;
-	 case  STORE: 
-	         // Store AC into address on next line
-	 	 temp = readMemory(registers[PC]++);
-		 writeMemory(temp, registers[AC]);
-	 	 break;
-	 case  GET: 
-	         // Get random value between 1-100
-	 	 registers[AC] = (rand() % 100) + 1;
-	 	 break;
-	 case  PUT: 
-	         // Put command based on port value in next line
-	 	 temp = readMemory(registers[PC]++);
-		 switch(temp)
-		 {
-		    case 1: // Print int in AC as int
-		           cout << registers[AC];
-			   break;
-	            case 2: // Print int in AC as char
-		           cout << (char)registers[AC];
-			   break;
-		    default:
-		           endProcess(INVALID_PORT_CALL);
-			   break;
-		 }
-	 	 break;
-	 case ADDX:
-	         // Add X to AC
-	 	 registers[AC] += registers[X];
-	 	 break;
-	 case ADDY: 
-	         // Add Y to AC
-	 	 registers[AC] += registers[Y];
-	 	 break;
-	 case SUBX: 
-	         // Subtract X from AC
-	 	 registers[AC] -= registers[X];
-	 	 break;
-	 case SUBY: 
-	         // Subtract Y from AC
-	 	 registers[AC] -= registers[Y];
-	 	 break;
-	 case COPY_TO_X: 
-	         // Copy AC to X
-	 	 registers[X] = registers[AC];
-	 	 break;
-	 case COPY_FR_X:
-	         // Copy X to AC
-	 	 registers[AC] = registers[X];
-	 	 break;
-	 case COPY_TO_Y: 
-	         // Copy AC to Y
-	 	 registers[Y] = registers[AC];
-	 	 break;
-	 case COPY_FR_Y:  
-                 // Copy Y to AC
-	 	 registers[AC] = registers[Y];
-	 	 break;
-	 case COPY_TO_SP: 
-	         // Copy AC to SP
-	 	 registers[SP] = registers[AC];
-	 	 break;
-	 case COPY_FR_SP: 
-	         // Copy SP to AC
-	 	 registers[AC] = registers[SP];
-	 	 break;
-         case JUMP: 
-	         // Jump to address
-	 	 registers[PC] = readMemory(registers[PC]);
-	 	 break;
-	 case JUMP_IF_EQ: 
-	         // Jump to address only if value in AC is zero
-		 temp = readMemory(registers[PC]++);
-	 	 if(!registers[AC])
-		    registers[PC] = temp;
-		 break;
-	 case JUMP_IF_NEQ: 
-	         // Jump to address only if value in AC is not zero
-		 temp = readMemory(registers[PC]++);
-	 	 if(registers[AC])
-		    registers[PC] = temp;
-	 	 break;
-	 case JUMP_RETURN: 
-	         // Push return address onto stack, jump to the address
-	 	 pushStack(registers[PC] + 1);
-		 registers[PC] = readMemory(registers[PC]);
-		 break;
-	 case RETURN: 
-	         // Pop return address from the stack, jump to the address
-		 registers[PC] = popStack();
-	 	 break;
-	 case INCX: 
-	         // Increment value in X
-	 	 registers[X]++;
-	 	 break;
-	 case DECX: 
-	         // Decrement value in X
-	 	 registers[X]--;
-	 	 break;
-	 case PUSH: 
-	         // Push: Push AC onto stack
-	 	 pushStack(registers[AC]);
-	 	 break;
-	 case POP: 
-	         // Pop from stack into AC
-	 	 registers[AC] = popStack();
-	 	 break;
-	 case SYSCALL: 
-	         // Perform system call
-                 syscall(INT_INDEX);	 	 
-	 	 break;
-	 case SYSRETURN: 
-	         // Return from system call
-	 	 return_syscall(); 
-	 	 break;
-	 case END: 
-	         // End execution
-	 	 endProcess(SUCCESS); 
-	 	 break;
-	 default: 
-	         // Invalid Op Code
-	 	 endProcess(INVALID_OPCODE); 
-      }
+/* Read Stream
+ * Read an instruction stream word, from the decoupled fetch
+ * unit when it has the word and from main memory otherwise.
+ * Access is verified the same way in both cases.
+ *
+ * <address> address to read
+ * <proven> address proven in bounds by the static analysis
+ * <return> word at the address
+ */
+int readStream(int address, bool proven)
+{
+   int value;
+   if(fetch_stream_word(address, &value))
+   {
+      if(!proven)
+         verifyAccess(address);
+      return value;
+   }
+
+   if(proven)
+      return readMemoryUnchecked(address);
+   return readMemory(address);
 }
 
 /* Print Registers and Stack
@@ -588,7 +690,7 @@ void debugProgram()
    printRegistersAndStack();
 
    cout << endl <<"Pushing stack..." << endl;
-   pushRegistersOnStack();
+   push_registers(cpu);
    
    printRegistersAndStack();
 
@@ -602,7 +704,7 @@ void debugProgram()
    printRegistersAndStack();
 
    cout << endl << "Popping stack..." << endl;
-   popRegistersOnStack();
+   pop_registers(cpu);
 
    printRegistersAndStack();
 
@@ -0,0 +1,192 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Program Profile
+//   Implementation below is executed by the processor process.
+//   Host profilers only see the interpreter, so with --profile
+//   the processor attributes host time to simulated program
+//   locations itself: the time between two retires is charged
+//   to the instruction that retired.  At exit the instructions
+//   are grouped into the basic blocks that were executed and
+//   written out by time, each named by its address range and
+//   disassembly.
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "program.h"
+using namespace std;
+
+// Instructions of a block disassembled in the profile
+#define PROFILE_BLOCK_LISTING 8
+
+// Executed basic block
+struct profile_block
+{
+   int start;
+   int end;
+   long long nanos;
+   long long instructions;
+   long long entries;
+};
+
+// Methods
+string    blockListing(int start, int end);
+
+// Profile file path (NULL = none)
+const char *profile_file = NULL;
+
+// Per address: host time, retires, entries from a jump or
+// interrupt, and the opcode that retired there
+long long profile_nanos[MEMORY_SIZE];
+long long profile_count[MEMORY_SIZE];
+long long profile_entries[MEMORY_SIZE];
+int profile_opcode[MEMORY_SIZE];
+
+// Time of the last retire and the address expected next
+long long profile_last = 0;
+long long profile_start = 0;
+int profile_next = 0;
+
+/* Set Profile File
+ * <path> file to write the profile to, or NULL
+ */
+void set_profile_file(const char *path)
+{
+   profile_file = path;
+}
+
+/* Start Profile
+ * Marks the start of execution.
+ */
+void start_profile()
+{
+   if(profile_file == NULL)
+      return;
+   profile_start = profile_last = monotonic_nanos();
+   profile_next = 0;
+   profile_entries[0]++;
+}
+
+/* Profile Retire
+ * Charges the time since the last retire to an instruction.
+ * Called by the execution cycle after every instruction.
+ *
+ * <address> address of the instruction
+ * <opcode> opcode of the instruction
+ */
+void profile_retire(int address, int opcode)
+{
+   if(profile_file == NULL || address < 0 || address >= MEMORY_SIZE)
+      return;
+
+   long long now = monotonic_nanos();
+   profile_nanos[address] += now - profile_last;
+   profile_last = now;
+   profile_count[address]++;
+   profile_opcode[address] = opcode;
+
+   // Control arrived other than by falling through, by a
+   // jump, call, return or interrupt
+   if(address != profile_next)
+      profile_entries[address]++;
+   profile_next = address + (opcode_has_operand(opcode) ? 2 : 1);
+}
+
+/* Write Profile
+ * Groups the executed instructions into basic blocks and
+ * writes them to the profile file, most expensive first.
+ */
+void write_profile()
+{
+   if(profile_file == NULL)
+      return;
+
+   // A block starts at an entered instruction and runs
+   // through the executed instructions falling through
+   vector<profile_block> blocks;
+   long long total = 0;
+   for(int address = 0; address < MEMORY_SIZE; address++)
+   {
+      if(profile_count[address] == 0)
+         continue;
+
+      profile_block block = { address, address, 0, 0, profile_entries[address] };
+      int next = address;
+      while(next < MEMORY_SIZE && profile_count[next] > 0 &&
+            (next == address || profile_entries[next] == 0))
+      {
+         block.end = next;
+         block.nanos += profile_nanos[next];
+	 block.instructions += profile_count[next];
+	 next += opcode_has_operand(profile_opcode[next]) ? 2 : 1;
+      }
+      total += block.nanos;
+      blocks.push_back(block);
+      address = next - 1;
+   }
+   sort(blocks.begin(), blocks.end(),
+        [](const profile_block &a, const profile_block &b) { return a.nanos > b.nanos; });
+
+   ofstream file(profile_file);
+   file << "# simos profile: " << blocks.size() << " blocks, "
+        << fixed << setprecision(3) << (profile_last - profile_start) / 1e6 << " ms" << endl;
+   file << "#  time%      host ms  instructions   entries  block" << endl;
+   for(size_t i = 0; i < blocks.size(); i++)
+   {
+      const profile_block &block = blocks[i];
+      file << setw(8) << setprecision(2) << (total > 0 ? 100.0 * block.nanos / total : 0)
+           << setw(13) << setprecision(3) << block.nanos / 1e6
+	   << setw(14) << block.instructions
+	   << setw(10) << block.entries
+	   << "  " << block.start << "-" << block.end
+	   << (block.start >= SYS_INDEX ? " [kernel]" : "")
+	   << ": " << blockListing(block.start, block.end) << endl;
+   }
+}
+
+/* Block Listing
+ * <start> first instruction address
+ * <end> last instruction address
+ * <return> mnemonics of the block's first instructions
+ */
+string blockListing(int start, int end)
+{
+   stringstream listing;
+   int shown = 0;
+   for(int address = start; address <= end; shown++)
+   {
+      if(shown == PROFILE_BLOCK_LISTING)
+      {
+         listing << "; ...";
+	 break;
+      }
+      if(shown > 0)
+         listing << "; ";
+      listing << opcode_name(profile_opcode[address]);
+      address += opcode_has_operand(profile_opcode[address]) ? 2 : 1;
+   }
+   return listing.str();
+}
+
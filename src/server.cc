@@ -0,0 +1,371 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Memory Server
+//   A long-lived daemon which keeps parsed program images
+//   cached by content in sealed memory files.  The main
+//   memory process of each run attaches over a local socket,
+//   receives the image file descriptor and maps it privately,
+//   so it gets a copy-on-write image without parsing.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <stdint.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "program.h"
+using namespace std;
+
+// Main memory of the memory process
+extern int *memory;
+
+// Most images the daemon keeps open
+#define IMAGE_CACHE_LIMIT 64
+
+// Sealed image of a program, with the text it was parsed from
+// to tell programs with the same hash apart
+struct cached_image
+{
+   string content;
+   int fd;
+   unsigned long long lastUse;
+};
+
+// Methods
+int  connectServer(const char *socketPath);
+void serveRequest(int client);
+int  cachedImage(const string &content);
+void evictImage();
+uint64_t contentHash(const string &content);
+bool sendImage(int client, int status, int fd);
+
+// Socket of the memory server to attach to (NULL = none)
+const char *server_socket = NULL;
+
+// Sealed image files keyed by program content hash, and the
+// request count for least recently used eviction
+multimap<uint64_t, cached_image> image_cache;
+unsigned long long image_requests = 0;
+
+/* Set Memory Server
+ * Selects the memory server socket used to load programs.
+ *
+ * <socketPath> server socket path or NULL
+ */
+void set_memory_server(const char *socketPath)
+{
+   server_socket = socketPath;
+}
+
+/* Connect Server
+ * <socketPath> server socket path
+ * <return> connected socket or -1
+ */
+int connectServer(const char *socketPath)
+{
+   struct sockaddr_un address;
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if(strlen(socketPath) >= sizeof(address.sun_path))
+      return -1;
+   strcpy(address.sun_path, socketPath);
+
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(fd == -1)
+      return -1;
+   if(connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1)
+   {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* Attach Memory Server
+ * Requests the image of a program from the memory server
+ * and maps it copy-on-write as main memory.  Any failure
+ * falls back to parsing the file locally.
+ *
+ * <file> input file path
+ * <return> true if main memory is now the server image
+ */
+bool attach_memory_server(const char *file)
+{
+   if(server_socket == NULL)
+      return false;
+
+   // Server may run in another directory
+   char path[PATH_MAX];
+   if(realpath(file, path) == NULL)
+      return false;
+
+   int server = connectServer(server_socket);
+   if(server == -1)
+      return false;
+
+   // Send the path length and path
+   int length = strlen(path);
+   if(write(server, &length, sizeof(int)) != sizeof(int) ||
+      write(server, path, length) != length)
+   {
+      close(server);
+      return false;
+   }
+
+   // Receive the status and the image file descriptor
+   int status = -1;
+   struct iovec data = { &status, sizeof(int) };
+   char control[CMSG_SPACE(sizeof(int))];
+   struct msghdr message;
+   memset(&message, 0, sizeof(message));
+   message.msg_iov = &data;
+   message.msg_iovlen = 1;
+   message.msg_control = control;
+   message.msg_controllen = sizeof(control);
+
+   ssize_t received = recvmsg(server, &message, 0);
+   close(server);
+
+   struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+   if(received != sizeof(int) || status != SUCCESS || header == NULL ||
+      header->cmsg_type != SCM_RIGHTS)
+      return false;
+
+   int fd;
+   memcpy(&fd, CMSG_DATA(header), sizeof(int));
+
+   // Private mapping: stores copy only the pages they touch
+   void *image = mmap(NULL, MEMORY_SIZE * sizeof(int), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(image == MAP_FAILED)
+      return false;
+
+   memory = (int *)image;
+   return true;
+}
+
+/* Run Memory Server
+ * Daemon routine.  Listens on a local socket and answers
+ * each request with the cached image of the program.
+ *
+ * <socketPath> server socket path
+ * <return> exit status (only on setup failure)
+ */
+int run_memory_server(const char *socketPath)
+{
+   struct sockaddr_un address;
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if(strlen(socketPath) >= sizeof(address.sun_path))
+   {
+      cerr << "Socket path too long" << endl;
+      return CLI_FAILURE;
+   }
+   strcpy(address.sun_path, socketPath);
+
+   int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+   unlink(socketPath);
+   if(listener == -1 ||
+      bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+      listen(listener, 64) == -1)
+   {
+      cerr << "Failed to open memory server socket" << endl;
+      return PIPE_FAILURE;
+   }
+
+   cout << "Memory server listening on " << socketPath << endl;
+
+   while(true)
+   {
+      int client = accept(listener, NULL, NULL);
+      if(client == -1)
+         continue;
+      serveRequest(client);
+      close(client);
+   }
+}
+
+/* Serve Request
+ * Reads a program path, looks up or builds its image and
+ * sends the image file descriptor back.
+ *
+ * <client> connected client socket
+ */
+void serveRequest(int client)
+{
+   int length;
+   if(read(client, &length, sizeof(int)) != sizeof(int) ||
+      length <= 0 || length >= PATH_MAX)
+      return;
+
+   string path(length, '\0');
+   if(read(client, &path[0], length) != length)
+      return;
+
+   // Read the program text; the cache is keyed by content
+   // so edited files are never served stale
+   ifstream file_stream(path.c_str());
+   if(!file_stream.is_open())
+   {
+      sendImage(client, FILE_PARSE_FAILURE, -1);
+      return;
+   }
+   stringstream content;
+   content << file_stream.rdbuf();
+
+   int fd = cachedImage(content.str());
+   if(fd == -1)
+   {
+      cout << "Failed to load " << path << endl;
+      sendImage(client, FILE_PARSE_FAILURE, -1);
+      return;
+   }
+
+   sendImage(client, SUCCESS, fd);
+}
+
+/* Cached Image
+ * Finds the image for the program text, parsing it into a
+ * new sealed memory file on a cache miss.  A hit must match
+ * the whole text, not only its hash.
+ *
+ * <content> program text
+ * <return> image file descriptor or -1 on parse failure
+ */
+int cachedImage(const string &content)
+{
+   uint64_t hash = contentHash(content);
+   image_requests++;
+   auto range = image_cache.equal_range(hash);
+   for(auto entry = range.first; entry != range.second; entry++)
+      if(entry->second.content == content)
+      {
+         entry->second.lastUse = image_requests;
+         return entry->second.fd;
+      }
+
+   size_t size = MEMORY_SIZE * sizeof(int);
+   int fd = memfd_create("simos-image", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+   if(fd == -1 || ftruncate(fd, size) == -1)
+   {
+      if(fd != -1)
+         close(fd);
+      return -1;
+   }
+
+   int *image = (int *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(image == MAP_FAILED)
+   {
+      close(fd);
+      return -1;
+   }
+
+   istringstream text(content);
+   bool success = simos::load_program_stream(text, image);
+   munmap(image, size);
+
+   // Seal the image so no client can change the shared copy
+   if(!success || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+                        F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+   {
+      close(fd);
+      return -1;
+   }
+
+   if(image_cache.size() == IMAGE_CACHE_LIMIT)
+      evictImage();
+   image_cache.insert({hash, {content, fd, image_requests}});
+   return fd;
+}
+
+/* Evict Image
+ * Closes the least recently used image.  Runs already holding
+ * it keep their own descriptor or mapping.
+ */
+void evictImage()
+{
+   auto oldest = image_cache.begin();
+   for(auto entry = image_cache.begin(); entry != image_cache.end(); entry++)
+      if(entry->second.lastUse < oldest->second.lastUse)
+         oldest = entry;
+   close(oldest->second.fd);
+   image_cache.erase(oldest);
+}
+
+/* Content Hash
+ * 64-bit FNV-1a hash of the program text.
+ *
+ * <content> program text
+ * <return> hash value
+ */
+uint64_t contentHash(const string &content)
+{
+   uint64_t hash = 14695981039346656037ULL;
+   for(size_t i = 0; i < content.size(); i++)
+   {
+      hash ^= (unsigned char)content[i];
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+/* Send Image
+ * Sends the status and, on success, the image file
+ * descriptor to the client.
+ *
+ * <client> connected client socket
+ * <status> status code
+ * <fd> image file descriptor or -1
+ * <return> true if sent
+ */
+bool sendImage(int client, int status, int fd)
+{
+   struct iovec data = { &status, sizeof(int) };
+   char control[CMSG_SPACE(sizeof(int))];
+   struct msghdr message;
+   memset(&message, 0, sizeof(message));
+   message.msg_iov = &data;
+   message.msg_iovlen = 1;
+
+   if(fd != -1)
+   {
+      memset(control, 0, sizeof(control));
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+      struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+      header->cmsg_level = SOL_SOCKET;
+      header->cmsg_type = SCM_RIGHTS;
+      header->cmsg_len = CMSG_LEN(sizeof(int));
+      memcpy(CMSG_DATA(header), &fd, sizeof(int));
+   }
+
+   return sendmsg(client, &message, 0) == sizeof(int);
+}
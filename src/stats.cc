@@ -0,0 +1,294 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Run Statistics
+//   Implementation below is executed by the processor process.
+//   With --stats, a summary of the run is printed to stderr
+//   when the processor ends: instructions, main memory
+//   requests, elapsed time, the process placement and the
+//   digest of main memory.  The instructions, memory requests
+//   and host time are also split between user code and each
+//   interrupt handler.  A handler's share is split again into
+//   its body and the frames pushed on entry and popped by
+//   IRet, which cost a memory request per saved register.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <algorithm>
+#include "program.h"
+using namespace std;
+
+// Phases of an interrupt
+enum stats_phase
+{
+   PHASE_BODY,
+   PHASE_ENTRY_FRAME,
+   PHASE_EXIT_FRAME,
+   PHASE_COUNT
+};
+
+// Cost charged to user code or a part of a handler
+struct stats_bucket
+{
+   long long instructions;
+   long long requests;
+   long long nanos;
+};
+
+// Processor state
+extern int instruction_counter;
+extern long long memory_requests;
+
+// Methods
+void      switchBucket(stats_bucket *next);
+stats_bucket *retireBucket(int address);
+void      printBucket(const char *name, const stats_bucket &bucket, long long entries);
+stats_bucket handlerTotal(int slot);
+
+// Statistics enabled flag and start of the run
+bool stats_enabled = false;
+long long stats_start = 0;
+
+// User and per-handler costs, the bucket being charged and
+// the cost counters when it started
+stats_bucket user_bucket;
+stats_bucket handler_buckets[VECTOR_COUNT][PHASE_COUNT];
+long long handler_entries[VECTOR_COUNT];
+stats_bucket *current_bucket = &user_bucket;
+long long bucket_start_nanos = 0;
+long long bucket_start_requests = 0;
+
+// Handler last entered and the interrupt nesting depth
+int current_handler = -1;
+int handler_depth = 0;
+int max_handler_depth = 0;
+
+/* Set Stats
+ * <enabled> print statistics at the end of the run
+ */
+void set_stats(bool enabled)
+{
+   stats_enabled = enabled;
+}
+
+/* Start Stats
+ * Marks the start of execution.
+ */
+void start_stats()
+{
+   stats_start = bucket_start_nanos = monotonic_nanos();
+   bucket_start_requests = memory_requests;
+}
+
+/* Stats Retire
+ * Charges an instruction to user code, or to the handler
+ * last entered for kernel addresses.
+ *
+ * <address> address of the instruction
+ */
+void stats_retire(int address)
+{
+   if(stats_enabled)
+      retireBucket(address)->instructions++;
+}
+
+/* Stats Skip
+ * Charges the instructions of loop iterations skipped by
+ * fast-forward, which never pass through stats_retire.
+ *
+ * <address> address of the loop branch
+ * <instructions> instructions skipped
+ */
+void stats_skip(int address, long long instructions)
+{
+   if(stats_enabled)
+      retireBucket(address)->instructions += instructions;
+}
+
+/* Stats Interrupt Entry
+ * Called when an interrupt is taken, before the registers
+ * are saved.
+ *
+ * <vector> interrupt handler address
+ */
+void stats_interrupt_entry(int vector)
+{
+   if(!stats_enabled || simos::vector_slot(vector) == -1)
+      return;
+   current_handler = simos::vector_slot(vector);
+   handler_entries[current_handler]++;
+   max_handler_depth = max(max_handler_depth, ++handler_depth);
+   switchBucket(&handler_buckets[current_handler][PHASE_ENTRY_FRAME]);
+}
+
+/* Stats Handler Start
+ * Called once the registers are saved and the handler runs.
+ */
+void stats_handler_start()
+{
+   if(stats_enabled && current_handler != -1)
+      switchBucket(&handler_buckets[current_handler][PHASE_BODY]);
+}
+
+/* Stats Interrupt Exit
+ * Called by IRet before the registers are restored.
+ */
+void stats_interrupt_exit()
+{
+   if(stats_enabled && current_handler != -1)
+      switchBucket(&handler_buckets[current_handler][PHASE_EXIT_FRAME]);
+}
+
+/* Stats Return To User
+ * Called once the registers are restored.
+ */
+void stats_return_to_user()
+{
+   if(!stats_enabled)
+      return;
+   if(handler_depth > 0)
+      handler_depth--;
+   switchBucket(&user_bucket);
+}
+
+/* Print Stats
+ * Prints the statistics of the run to stderr.  Called
+ * while main memory is still running.
+ */
+void print_stats()
+{
+   if(!stats_enabled)
+      return;
+
+   // Close the bucket being charged before the digest request
+   double elapsed = (monotonic_nanos() - stats_start) / 1e9;
+   switchBucket(current_bucket);
+
+   cerr << "STATISTICS:" << endl;
+   cerr << "  Instructions:      " << instruction_counter << endl;
+   cerr << "  Memory requests:   " << memory_requests << endl;
+   cerr << "  Elapsed:           " << elapsed << " s" << endl;
+   if(memory_requests > 0)
+      cerr << "  Time per request:  " << elapsed * 1e6 / memory_requests << " us" << endl;
+   cerr << "  Placement:         " << describe_placement() << endl;
+   cerr << "  Memory digest:     " << hex << setfill('0') << setw(16)
+        << memory_digest() << dec << setfill(' ') << endl;
+
+   const char *handlerNames[VECTOR_COUNT] = { "timer (1000)", "input (1250)", "syscall (1500)" };
+   stats_bucket kernel = { 0, 0, 0 };
+   long long kernelEntries = 0;
+   for(int slot = 0; slot < VECTOR_COUNT; slot++)
+   {
+      stats_bucket total = handlerTotal(slot);
+      kernel.instructions += total.instructions;
+      kernel.requests += total.requests;
+      kernel.nanos += total.nanos;
+      kernelEntries += handler_entries[slot];
+   }
+
+   cerr << "  Mode split:                instructions  mem requests     host ms   entries" << endl;
+   printBucket("    user", user_bucket, 0);
+   printBucket("    kernel", kernel, kernelEntries);
+   for(int slot = 0; slot < VECTOR_COUNT; slot++)
+   {
+      if(handler_entries[slot] == 0)
+         continue;
+      printBucket((string("      ") + handlerNames[slot]).c_str(), handlerTotal(slot), handler_entries[slot]);
+      printBucket("        handler", handler_buckets[slot][PHASE_BODY], 0);
+      printBucket("        entry frame", handler_buckets[slot][PHASE_ENTRY_FRAME], 0);
+      printBucket("        exit frame", handler_buckets[slot][PHASE_EXIT_FRAME], 0);
+   }
+
+   long long instructions = user_bucket.instructions + kernel.instructions;
+   long long requests = user_bucket.requests + kernel.requests;
+   long long nanos = user_bucket.nanos + kernel.nanos;
+   cerr << "  Kernel share:      " << fixed << setprecision(1)
+        << (instructions > 0 ? 100.0 * kernel.instructions / instructions : 0) << "% of instructions, "
+        << (requests > 0 ? 100.0 * kernel.requests / requests : 0) << "% of memory requests, "
+        << (nanos > 0 ? 100.0 * kernel.nanos / nanos : 0) << "% of host time" << endl;
+   cerr.unsetf(ios::floatfield);
+   cerr << setprecision(6);
+   cerr << "  Nesting depth:     " << max_handler_depth << endl;
+   cerr << endl;
+}
+
+/* Switch Bucket
+ * Charges the host time and memory requests since the last
+ * switch to the current bucket and starts charging another.
+ *
+ * <next> bucket to charge from now on
+ */
+void switchBucket(stats_bucket *next)
+{
+   long long now = monotonic_nanos();
+   current_bucket->nanos += now - bucket_start_nanos;
+   current_bucket->requests += memory_requests - bucket_start_requests;
+   bucket_start_nanos = now;
+   bucket_start_requests = memory_requests;
+   current_bucket = next;
+}
+
+/* Retire Bucket
+ * <address> address of a retired instruction
+ * <return> user bucket, or the body of the handler last
+ * entered for kernel addresses
+ */
+stats_bucket *retireBucket(int address)
+{
+   if(address < SYS_INDEX || current_handler == -1)
+      return &user_bucket;
+   return &handler_buckets[current_handler][PHASE_BODY];
+}
+
+/* Handler Total
+ * <slot> handler index
+ * <return> cost of the handler body and both frames
+ */
+stats_bucket handlerTotal(int slot)
+{
+   stats_bucket total = { 0, 0, 0 };
+   for(int phase = 0; phase < PHASE_COUNT; phase++)
+   {
+      total.instructions += handler_buckets[slot][phase].instructions;
+      total.requests += handler_buckets[slot][phase].requests;
+      total.nanos += handler_buckets[slot][phase].nanos;
+   }
+   return total;
+}
+
+/* Print Bucket
+ * <name> row label
+ * <bucket> costs to print
+ * <entries> handler entries, or 0 to leave blank
+ */
+void printBucket(const char *name, const stats_bucket &bucket, long long entries)
+{
+   cerr << "  " << left << setw(24) << name << right
+        << setw(14) << bucket.instructions
+        << setw(14) << bucket.requests
+        << setw(12) << fixed << setprecision(3) << bucket.nanos / 1e6;
+   if(entries > 0)
+      cerr << setw(10) << entries;
+   cerr << endl;
+   cerr.unsetf(ios::floatfield);
+   cerr << setprecision(6);
+}
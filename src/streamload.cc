@@ -0,0 +1,261 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Streaming Loader
+//   Implementation below is executed by the main memory
+//   process.  With --stream-load, the program is parsed on a
+//   loader thread while main memory already serves requests.
+//   A page is published once the loader moves past it, and
+//   main memory reports the program loaded as soon as the
+//   entry page is published, so the processor starts at PC=0
+//   no matter how long the rest of the file takes to arrive.
+//   Requests to a page that is not published yet sleep on a
+//   futex until the loader publishes it.  A published page is
+//   final: a line that moves the load address back into one,
+//   or stores into one, fails the load.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <climits>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "program.h"
+using namespace std;
+
+// Words per published page
+#define LOAD_PAGE_WORDS 64
+#define LOAD_PAGE_COUNT ((MEMORY_SIZE + LOAD_PAGE_WORDS - 1) / LOAD_PAGE_WORDS)
+
+// Methods
+void streamThread(ifstream *file_stream, int image[]);
+void publishPage(int page);
+void waitForFlag(atomic<int> &flag);
+void setFlag(atomic<int> &flag);
+
+// Streaming flag
+bool stream_load = false;
+
+// Published pages and the state of the loader thread.  The
+// flags are ints so that waiters can sleep on them.
+atomic<int> page_published[LOAD_PAGE_COUNT];
+atomic<int> load_done(1);
+atomic<bool> load_failed(false);
+
+/* Set Stream Load
+ * <enabled> execute while the program is still loading
+ */
+void set_stream_load(bool enabled)
+{
+   stream_load = enabled;
+}
+
+/* Stream Load Enabled
+ * <return> true if programs are loaded while executing
+ */
+bool stream_load_enabled()
+{
+   return stream_load;
+}
+
+/* Start Stream Load
+ * Opens the program file and starts the loader thread.
+ * Returns once the entry page is published or the load
+ * has ended.
+ *
+ * <file> input file path
+ * <image> memory image of MEMORY_SIZE words to populate
+ * <return> false if the entry page could not be loaded
+ */
+bool start_stream_load(const char *file, int image[])
+{
+   ifstream *file_stream = new ifstream(file);
+   if(!file_stream->is_open())
+   {
+      delete file_stream;
+      return false;
+   }
+
+   for(int page = 0; page < LOAD_PAGE_COUNT; page++)
+      page_published[page] = 0;
+   load_failed = false;
+   load_done = 0;
+
+   // Requests are served by the main thread only
+   sigset_t blocked, previous;
+   sigemptyset(&blocked);
+   sigaddset(&blocked, SIGINT);
+   sigaddset(&blocked, SIGUSR1);
+   pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+   thread loader(streamThread, file_stream, image);
+   loader.detach();
+   pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+   return wait_for_page(0);
+}
+
+/* Wait For Page
+ * Waits until the page holding an address is published.
+ * Safe to call from the request handlers.
+ *
+ * <address> address in main memory
+ * <return> false if the load failed
+ */
+bool wait_for_page(int address)
+{
+   if(address < 0 || address >= MEMORY_SIZE)
+      return true;
+
+   if(!load_done.load(memory_order_acquire))
+      waitForFlag(page_published[address / LOAD_PAGE_WORDS]);
+   return !load_failed;
+}
+
+/* Page Is Published
+ * <address> address in main memory
+ * <return> true if the word at the address is loaded
+ */
+bool page_is_published(int address)
+{
+   if(load_done.load(memory_order_acquire))
+      return !load_failed;
+   return page_published[address / LOAD_PAGE_WORDS].load(memory_order_acquire);
+}
+
+/* Wait For Stream Load
+ * Waits until the whole program is loaded.
+ *
+ * <return> false if the load failed
+ */
+bool wait_for_stream_load()
+{
+   waitForFlag(load_done);
+   return !load_failed;
+}
+
+/* Stream Load Pending
+ * <return> true while the loader thread is still running
+ */
+bool stream_load_pending()
+{
+   return !load_done.load(memory_order_acquire);
+}
+
+/* Stream Thread
+ * Parses the program line by line into the image and
+ * publishes each page once the load address leaves it.
+ * Pages never left are published when the load ends.  A
+ * directive or store into a published page fails the load,
+ * since the processor may already have read the page.
+ *
+ * <file_stream> open program file, owned by the thread
+ * <image> memory image to populate
+ */
+void streamThread(ifstream *file_stream, int image[])
+{
+   int address = 0;
+   int currentPage = -1;
+   int number;
+   string line;
+
+   try{
+      while(getline(*file_stream, line))
+      {
+         int operation = simos::parse_program_line(line.c_str(), line.length(), number);
+	 if(operation == JUMP_AHEAD)
+	 {
+	    // Leaving the page for another one, never back to
+	    // a published page
+	    address = number;
+	    if(address >= 0 && address < MEMORY_SIZE &&
+	       page_published[address / LOAD_PAGE_WORDS].load(memory_order_relaxed))
+	       throw FILE_PARSE_FAILURE;
+	    if(currentPage >= 0 && address / LOAD_PAGE_WORDS != currentPage)
+	    {
+	       publishPage(currentPage);
+	       currentPage = -1;
+	    }
+	 }
+	 else if(operation == LOAD)
+	 {
+	    // Address must be inside main memory
+	    if(address < 0 || address >= MEMORY_SIZE)
+	       throw FILE_PARSE_FAILURE;
+	    if(address / LOAD_PAGE_WORDS != currentPage)
+	    {
+	       if(currentPage >= 0)
+	          publishPage(currentPage);
+	       currentPage = address / LOAD_PAGE_WORDS;
+	       if(page_published[currentPage].load(memory_order_relaxed))
+	          throw FILE_PARSE_FAILURE;
+	    }
+	    image[address] = number;
+	    address++;
+	 }
+      }
+   }catch(...)
+   {
+      cout << "ERROR PARSING FILE!!!!" << endl;
+      load_failed = true;
+   }
+
+   // The load has ended, then wake requests to any page
+   delete file_stream;
+   setFlag(load_done);
+   for(int page = 0; page < LOAD_PAGE_COUNT; page++)
+      publishPage(page);
+}
+
+/* Publish Page
+ * <page> page whose words are loaded
+ */
+void publishPage(int page)
+{
+   if(page_published[page].load(memory_order_relaxed) == 0)
+      setFlag(page_published[page]);
+}
+
+/* Wait For Flag
+ * Sleeps until a flag is set.  Only makes system calls, so
+ * it is safe in the request handlers.
+ *
+ * <flag> flag set once by the loader thread
+ */
+void waitForFlag(atomic<int> &flag)
+{
+   while(flag.load(memory_order_acquire) == 0)
+      syscall(SYS_futex, (int *)&flag, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+}
+
+/* Set Flag
+ * Sets a flag and wakes every thread waiting on it.
+ *
+ * <flag> flag to set
+ */
+void setFlag(atomic<int> &flag)
+{
+   flag.store(1, memory_order_release);
+   syscall(SYS_futex, (int *)&flag, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
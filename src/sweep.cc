@@ -0,0 +1,367 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Timer Sweep
+//   Implementation below is executed by the --sweep mode.
+//   Runs a program once per timer value in a range without
+//   repeating the work the runs share.  Until the first timer
+//   interrupt a run does not depend on its timer, so one
+//   libsimos machine runs with the timer off, and just before
+//   the instruction where timer T would fire it forks: the
+//   child is a copy-on-write snapshot that sets timer T and
+//   runs to the end.  Timers past the end of the parent's run
+//   never fire and share its result.  Children report into a
+//   shared mapping and the results are printed per timer.
+//   Every run stops at an instruction limit, since a small
+//   timer can interrupt a handler's IRet forever.  Runs have
+//   the devices of the processor process, but no disk: the
+//   forked runs would share one host file.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <thread>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "program.h"
+#include "simos.h"
+using namespace std;
+
+// Default instruction limit of a run
+#define SWEEP_LIMIT 1000000
+
+// Result of the run of one timer value
+struct sweep_result
+{
+   int done;
+   int limited;
+   int exitCode;
+   long long instructions;
+   long long interrupts;
+   long long forkPoint;
+   long long outputBytes;
+   uint64_t outputHash;
+};
+
+// Methods
+int       prepareMachine(simos::machine &machine, const char *file, const string &input,
+                         int refreshInterval, const vector<int> &nativeVectors);
+void      finishRun(simos::machine &machine, sweep_result &result, long long forkPoint);
+void      waitForChild(int &children);
+uint64_t  outputHash(const string &text);
+bool      sameResult(const sweep_result &a, const sweep_result &b);
+
+/* Run Sweep
+ * Sweep mode: runs the program for every timer value in a
+ * range and prints the results, merging runs of timers with
+ * identical results.
+ *
+ * <argc> arg count
+ * <argv> --sweep <file> <first> <last> [options]
+ * <return> SUCCESS, or an error code for bad options or input
+ */
+int run_sweep(int argc, char *argv[])
+{
+   const char *file = argv[2];
+   int first, last;
+   long long limit = SWEEP_LIMIT;
+   int refreshInterval = 0;
+   string input;
+   vector<int> nativeVectors;
+   try{
+      first = stoi(argv[3]);
+      last = stoi(argv[4]);
+      if(first < 1 || last < first)
+         throw CLI_FAILURE;
+      for(int i = 5; i < argc; i++)
+      {
+         string option = argv[i];
+         if(option == "--input" && i + 1 < argc)
+         {
+            ifstream inputStream(argv[++i]);
+            if(!inputStream.is_open())
+            {
+               cerr << "Failed to open input file" << endl;
+               return INPUT_FAILURE;
+            }
+            input.assign(istreambuf_iterator<char>(inputStream), istreambuf_iterator<char>());
+         }
+         else if(option == "--limit" && i + 1 < argc)
+         {
+            limit = stoll(argv[++i]);
+            if(limit < 1)
+               throw CLI_FAILURE;
+         }
+         else if(option == "--fb-refresh" && i + 1 < argc)
+         {
+            refreshInterval = stoi(argv[++i]);
+            if(refreshInterval < 0)
+               throw CLI_FAILURE;
+         }
+         else if(option == "--disk")
+         {
+            cout << "ERROR: --sweep has no disk; its runs would share one disk file" << endl << endl;
+            return CLI_FAILURE;
+         }
+         else if(option == "--native" && i + 1 < argc)
+         {
+            int vector = stoi(argv[++i]);
+            if(vector != SYS_INDEX && vector != INPUT_INDEX && vector != INT_INDEX)
+               throw CLI_FAILURE;
+            nativeVectors.push_back(vector);
+         }
+         else
+            throw CLI_FAILURE;
+      }
+   }catch(...){
+      cout << "ERROR: Invalid options" << endl;
+      cout << "Usage: program1.exe --sweep <program_file> <first_timer> <last_timer>"
+              " [--input <file>] [--fb-refresh <instructions>] [--native <vector>]"
+              " [--limit <instructions>]" << endl << endl;
+      return CLI_FAILURE;
+   }
+
+   // One result slot per timer, shared with the children
+   int count = last - first + 1;
+   size_t bytes = count * sizeof(sweep_result);
+   void *address = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if(address == MAP_FAILED)
+   {
+      cerr << "Failed to map sweep results" << endl;
+      return MEMORY_ALLOC_FAILURE;
+   }
+   sweep_result *results = (sweep_result *)address;
+
+   simos::machine machine;
+   int status = prepareMachine(machine, file, input, refreshInterval, nativeVectors);
+   if(status != SUCCESS)
+   {
+      munmap(address, bytes);
+      return status;
+   }
+   cout.flush();
+
+   // Common prefix: the timer is off until a child sets it
+   int maxChildren = max((int)thread::hardware_concurrency(), 1);
+   int children = 0;
+   int next = first;
+   bool diverged = false;
+   while(next <= last && !machine.halted() && machine.instructions() < limit)
+   {
+      // Timer next fires on the coming instruction
+      if(machine.instructions() == next - 1)
+      {
+         if(children == maxChildren)
+            waitForChild(children);
+         int pid = fork();
+         if(pid == 0)
+         {
+            machine.set_timer(next);
+            machine.run(limit - machine.instructions());
+            finishRun(machine, results[next - first], next - 1);
+            _exit(0);
+         }
+         if(pid > 0)
+            children++;
+         next++;
+         continue;
+      }
+
+      machine.step();
+
+      // A run that sees its timer value depends on it from here
+      if(machine.timer_accesses() > 0)
+      {
+         diverged = true;
+         break;
+      }
+   }
+
+   // Remaining timers never fire before the end, or must be
+   // rerun from the start once the timer value was observed
+   sweep_result shared;
+   if(!diverged)
+      finishRun(machine, shared, 0);
+   for(int timer = next; timer <= last; timer++)
+   {
+      if(!diverged)
+      {
+         results[timer - first] = shared;
+         continue;
+      }
+      if(children == maxChildren)
+         waitForChild(children);
+      int pid = fork();
+      if(pid == 0)
+      {
+         simos::machine rerun;
+         prepareMachine(rerun, file, input, refreshInterval, nativeVectors);
+         rerun.set_timer(timer);
+         rerun.run(limit);
+         finishRun(rerun, results[timer - first], 0);
+         _exit(0);
+      }
+      if(pid > 0)
+         children++;
+   }
+   while(children > 0)
+      waitForChild(children);
+
+   // Print timers with identical results as one range
+   cout << "SWEEP: " << file << ", timers " << first << "-" << last << endl;
+   cout << "  timers         exit code                  instructions  interrupts  output" << endl;
+   long long executed = machine.instructions();
+   long long independent = 0;
+   int failed = 0;
+   for(int start = 0; start < count; )
+   {
+      const sweep_result &result = results[start];
+      int end = start;
+      while(end + 1 < count && results[end + 1].done && result.done &&
+            sameResult(results[end + 1], result))
+         end++;
+
+      stringstream range;
+      range << first + start;
+      if(end > start)
+         range << "-" << first + end;
+      cout << "  " << left << setw(15) << range.str();
+      if(!result.done)
+      {
+         cout << "(run failed)" << endl;
+         failed += end - start + 1;
+      }
+      else
+         cout << setw(25) << (result.limited ? "(limit reached)" : exit_code_name(result.exitCode)) << right
+              << setw(14) << result.instructions
+              << setw(12) << result.interrupts
+              << "  " << hex << setw(16) << setfill('0') << result.outputHash
+              << dec << setfill(' ') << " (" << result.outputBytes << " bytes)" << endl;
+      cout << right;
+
+      // Children ran past their fork point; shared results
+      // cost nothing more
+      for(int i = start; i <= end; i++)
+      {
+         independent += results[i].instructions;
+         if(i < next - first || diverged)
+            executed += results[i].instructions - results[i].forkPoint;
+      }
+      start = end + 1;
+   }
+   cout << "SUMMARY: " << next - first << " forked at their first interrupt, "
+        << (diverged ? "timer observed after " : "")
+        << (diverged ? to_string(machine.instructions()) + " instructions, " : "")
+        << last - next + 1 << (diverged ? " rerun" : " never interrupted") << endl;
+   cout << "  Instructions executed: " << executed
+        << " (independent runs: " << independent << ")" << endl << endl;
+
+   munmap(address, bytes);
+   return failed > 0 ? FORK_FAILURE : SUCCESS;
+}
+
+/* Prepare Machine
+ * Loads the program and applies the sweep options.
+ *
+ * <machine> machine to set up
+ * <file> program file path
+ * <input> console input
+ * <refreshInterval> framebuffer refresh interval, 0 for off
+ * <nativeVectors> vectors served by the native return handler
+ * <return> FILE_PARSE_FAILURE if the program could not be
+ * loaded, CLI_FAILURE if a vector does not hold a lone IRet,
+ * else SUCCESS
+ */
+int prepareMachine(simos::machine &machine, const char *file, const string &input,
+                   int refreshInterval, const vector<int> &nativeVectors)
+{
+   if(!machine.load_file(file))
+      return FILE_PARSE_FAILURE;
+   machine.set_input(input);
+   machine.set_framebuffer_refresh(refreshInterval);
+   for(size_t i = 0; i < nativeVectors.size(); i++)
+   {
+      if(!check_native_return(nativeVectors[i], machine.peek(nativeVectors[i])))
+         return CLI_FAILURE;
+      machine.set_native_handler(nativeVectors[i], [](simos::native_frame &frame) {});
+   }
+   return SUCCESS;
+}
+
+/* Finish Run
+ * <machine> halted machine
+ * <result> result slot to fill
+ * <forkPoint> instructions the run shared with the parent
+ */
+void finishRun(simos::machine &machine, sweep_result &result, long long forkPoint)
+{
+   result.limited = !machine.halted();
+   result.exitCode = machine.exit_code();
+   result.instructions = machine.instructions();
+   result.interrupts = machine.interrupts();
+   result.forkPoint = forkPoint;
+   result.outputBytes = machine.output().size();
+   result.outputHash = outputHash(machine.output());
+   result.done = 1;
+}
+
+/* Wait For Child
+ * Reaps one child run.
+ *
+ * <children> running children, decremented
+ */
+void waitForChild(int &children)
+{
+   if(wait(NULL) > 0)
+      children--;
+   else
+      children = 0;
+}
+
+/* Output Hash
+ * <text> console output of a run
+ * <return> 64-bit FNV-1a hash of the output
+ */
+uint64_t outputHash(const string &text)
+{
+   uint64_t hash = 14695981039346656037ULL;
+   for(size_t i = 0; i < text.size(); i++)
+   {
+      hash ^= (unsigned char)text[i];
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+/* Same Result
+ * <return> true if two runs ended the same way
+ */
+bool sameResult(const sweep_result &a, const sweep_result &b)
+{
+   return a.limited == b.limited && a.exitCode == b.exitCode && a.instructions == b.instructions &&
+          a.interrupts == b.interrupts && a.outputHash == b.outputHash &&
+          a.outputBytes == b.outputBytes;
+}
@@ -0,0 +1,423 @@
+//   Simulating an Operating System using Multiple Processes and IPC
+//
+//   Author: Jimmy Nguyen
+//   Email:  Jimmy@JimmyWorks.net
+//
+//   Description:
+//   Develop a multi-process program which emulates a
+//   basic operating system where the processor is the
+//   parent process and main memory is a child process.
+//   The processor process will communicate with the
+//   main memory process through signals and pipes for
+//   read/write, I/O operations.  The processor contains
+//   an array to emulate registers (PC, SP, IR, AC, X, Y)
+//   while main memory contains an array of 2000 elements
+//   to emulate memory space.  The processor process
+//   will simulate the execution cycle (fetch, decode, and
+//   execute), interrupt handling, mode switching (user and
+//   kernel mode), user and system stack, timeout timer, and
+//   implement over 30 different operations for the
+//   instruction set.
+//
+//   Zygote
+//   A server which keeps a pool of pre-forked processor and
+//   main memory pairs with their pipes already set up.  A job
+//   only carries the program path and timer (plus the client's
+//   stdin and stdout), so it starts on an idle pair without
+//   paying for fork.  The pool size follows the arrival rate.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include "program.h"
+using namespace std;
+
+// Seconds of arrivals the pool should absorb while refilling
+#define REFILL_SECONDS 0.05
+// Poll interval (ms) used to decay the arrival rate
+#define DECAY_INTERVAL 100
+
+// Idle pre-forked pair
+struct zygote_pair
+{
+   int pid;
+   int control;
+};
+
+// Methods
+bool spawnPair(vector<zygote_pair> &pool, bool debugMode);
+void runPair(int control, bool debugMode);
+void abortJob(int memoryPid, int exitCode);
+bool sendDescriptors(int socket, const void *data, int size, const int *fds, int count);
+int  receiveDescriptors(int socket, void *data, int size, int *fds, int count);
+
+// Client socket of the job this pair is running (-1 = none)
+int job_socket = -1;
+
+// Zygote listening socket and idle pool, closed in new pairs
+int zygote_listener = -1;
+vector<zygote_pair> *zygote_pool = NULL;
+
+/* Run Zygote
+ * Server routine.  Listens for jobs on a local socket and
+ * hands each one to an idle pair, keeping the pool sized
+ * to the recent arrival rate.
+ *
+ * <socketPath> server socket path
+ * <minPool> pairs kept idle with no traffic
+ * <maxPool> upper bound on idle pairs
+ * <debugMode> debug flag passed to the pairs
+ * <return> exit status (only on setup failure)
+ */
+int run_zygote(const char *socketPath, int minPool, int maxPool, bool debugMode)
+{
+   struct sockaddr_un address;
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if(strlen(socketPath) >= sizeof(address.sun_path))
+   {
+      cerr << "Socket path too long" << endl;
+      return CLI_FAILURE;
+   }
+   strcpy(address.sun_path, socketPath);
+
+   int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+   unlink(socketPath);
+   if(listener == -1 ||
+      bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+      listen(listener, 64) == -1)
+   {
+      cerr << "Failed to open zygote socket" << endl;
+      return PIPE_FAILURE;
+   }
+
+   // Consumed pairs are reaped explicitly below
+   vector<zygote_pair> pool;
+   zygote_listener = listener;
+   zygote_pool = &pool;
+   double rate = 0;
+   double lastArrival = monotonic_nanos() / 1e9;
+
+   cout << "Zygote listening on " << socketPath << endl;
+
+   while(true)
+   {
+      // Reap finished pairs, dropping any that died while idle
+      int pid;
+      while((pid = waitpid(-1, NULL, WNOHANG)) > 0)
+      {
+         for(size_t i = 0; i < pool.size(); i++)
+	    if(pool[i].pid == pid)
+	    {
+	       close(pool[i].control);
+	       pool.erase(pool.begin() + i);
+	       break;
+	    }
+      }
+
+      // Size the pool to the arrival rate
+      int target = minPool + (int)(rate * REFILL_SECONDS + 0.5);
+      if(target > maxPool)
+         target = maxPool;
+      while((int)pool.size() < target && spawnPair(pool, debugMode))
+      {
+      }
+      while((int)pool.size() > target)
+      {
+         kill(pool.back().pid, SIGKILL);
+	 close(pool.back().control);
+	 pool.pop_back();
+      }
+
+      struct pollfd waiting = { listener, POLLIN, 0 };
+      if(poll(&waiting, 1, DECAY_INTERVAL) <= 0)
+      {
+         // No arrivals, let the rate decay
+	 rate *= 0.8;
+         continue;
+      }
+
+      int client = accept(listener, NULL, NULL);
+      if(client == -1)
+         continue;
+
+      // Exponentially weighted arrival rate (jobs per second)
+      double now = monotonic_nanos() / 1e9;
+      double gap = now - lastArrival;
+      lastArrival = now;
+      rate = 0.8 * rate + 0.2 / (gap > 0.001 ? gap : 0.001);
+
+      // Take an idle pair, forking one if the pool ran dry
+      if(pool.empty() && !spawnPair(pool, debugMode))
+      {
+         close(client);
+	 continue;
+      }
+      zygote_pair pair = pool.back();
+      pool.pop_back();
+
+      // Hand the client connection to the pair
+      char token = 0;
+      sendDescriptors(pair.control, &token, 1, &client, 1);
+      close(pair.control);
+      close(client);
+   }
+}
+
+/* Spawn Pair
+ * Forks an idle processor which forks its main memory.
+ *
+ * <pool> pool to add the pair to
+ * <debugMode> debug flag
+ * <return> false if the fork failed
+ */
+bool spawnPair(vector<zygote_pair> &pool, bool debugMode)
+{
+   int control[2];
+   if(socketpair(AF_UNIX, SOCK_STREAM, 0, control) == -1)
+      return false;
+
+   int pid = fork();
+   if(pid == -1)
+   {
+      close(control[0]);
+      close(control[1]);
+      return false;
+   }
+   else if(pid == 0)
+   {
+      // Child: idle processor of the pair, which only
+      // keeps its own control socket
+      close(control[0]);
+      close(zygote_listener);
+      for(size_t i = 0; i < zygote_pool->size(); i++)
+         close((*zygote_pool)[i].control);
+      runPair(control[1], debugMode);
+   }
+
+   close(control[1]);
+   zygote_pair pair = { pid, control[0] };
+   pool.push_back(pair);
+   return true;
+}
+
+/* Run Pair
+ * Idle processor routine.  Forks main memory right away,
+ * then waits for a job, passes the program path to main
+ * memory and runs the processor on the client's terminal.
+ *
+ * <control> control socket to the zygote
+ * <debugMode> debug flag
+ */
+void runPair(int control, bool debugMode)
+{
+   // Die with the zygote while still idle
+   prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+   int processID[(int)pid_values::PIDCOUNT];
+   processID[PROCESSOR] = getpid();
+
+   int procToMem[2];
+   int memToProc[2];
+   int pid = fork_main_memory(NULL, procToMem, memToProc, debugMode);
+   if(pid < 0)
+      exit(-pid);
+   processID[MAIN_MEMORY] = pid;
+
+   // Wait for the client connection
+   char token;
+   int client;
+   if(receiveDescriptors(control, &token, 1, &client, 1) != 1)
+   {
+      kill(pid, SIGKILL);
+      exit(PROGRAM_PATH_FAILURE);
+   }
+   close(control);
+   job_socket = client;
+
+   // A running job outlives the zygote
+   prctl(PR_SET_PDEATHSIG, 0);
+
+   // Job: path length, timer, client stdin/stdout, then path
+   int header[2];
+   int stdio[2];
+   if(receiveDescriptors(client, header, sizeof(header), stdio, 2) != 2 ||
+      header[0] <= 0 || header[0] >= PATH_MAX || header[1] <= 0)
+      abortJob(pid, CLI_FAILURE);
+
+   string path(header[0], '\0');
+   if(read(client, &path[0], header[0]) != header[0])
+      abortJob(pid, CLI_FAILURE);
+
+   dup2(stdio[0], STDIN_FILENO);
+   dup2(stdio[1], STDOUT_FILENO);
+   close(stdio[0]);
+   close(stdio[1]);
+
+   // Main memory loads the program now
+   write(procToMem[1], &header[0], sizeof(int));
+   write(procToMem[1], path.c_str(), header[0]);
+
+   int loadSuccess;
+   read(memToProc[0], &loadSuccess, sizeof(loadSuccess));
+   if(!loadSuccess)
+      abortJob(pid, FILE_PARSE_FAILURE);
+   analyze_program(path.c_str());
+
+   run_processor(header[1], processID, procToMem, memToProc, debugMode);
+   endProcess(PROGRAM_PATH_FAILURE);
+}
+
+/* Abort Job
+ * Ends a job that failed before the processor started.
+ *
+ * <memoryPid> main memory pid
+ * <exitCode> Exit status value
+ */
+void abortJob(int memoryPid, int exitCode)
+{
+   kill(memoryPid, SIGKILL);
+   finish_job(exitCode);
+   exit(exitCode);
+}
+
+/* Finish Job
+ * Called on process exit.  Reports the exit code back to
+ * the client of a zygote job.
+ *
+ * <exitCode> Exit status value
+ */
+void finish_job(int exitCode)
+{
+   if(job_socket == -1)
+      return;
+   cout << flush;
+   write(job_socket, &exitCode, sizeof(int));
+   close(job_socket);
+   job_socket = -1;
+}
+
+/* Submit Job
+ * Client routine.  Sends the program path, timer and this
+ * process's stdin and stdout to the zygote, then waits for
+ * the job's exit code.
+ *
+ * <socketPath> zygote socket path
+ * <file> input file path
+ * <timer> interrupt timer
+ * <return> exit code of the job
+ */
+int submit_job(const char *socketPath, const char *file, int timer)
+{
+   // Zygote runs in another directory
+   char path[PATH_MAX];
+   if(realpath(file, path) == NULL)
+      return CLI_FAILURE;
+
+   struct sockaddr_un address;
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if(strlen(socketPath) >= sizeof(address.sun_path))
+      return CLI_FAILURE;
+   strcpy(address.sun_path, socketPath);
+
+   int server = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(server == -1 ||
+      connect(server, (struct sockaddr *)&address, sizeof(address)) == -1)
+   {
+      cerr << "Failed to connect to zygote" << endl;
+      return PIPE_FAILURE;
+   }
+
+   int header[2] = { (int)strlen(path), timer };
+   int stdio[2] = { STDIN_FILENO, STDOUT_FILENO };
+   cout << flush;
+   if(!sendDescriptors(server, header, sizeof(header), stdio, 2) ||
+      write(server, path, header[0]) != header[0])
+   {
+      close(server);
+      return PIPE_FAILURE;
+   }
+
+   int exitCode;
+   if(read(server, &exitCode, sizeof(int)) != sizeof(int))
+      exitCode = PROGRAM_PATH_FAILURE;
+   close(server);
+   return exitCode;
+}
+
+/* Send Descriptors
+ * Sends data together with file descriptors.
+ *
+ * <socket> unix socket
+ * <data> bytes to send
+ * <size> byte count
+ * <fds> descriptors to pass
+ * <count> descriptor count
+ * <return> true if sent
+ */
+bool sendDescriptors(int socket, const void *data, int size, const int *fds, int count)
+{
+   struct iovec iov = { (void *)data, (size_t)size };
+   char control[CMSG_SPACE(2 * sizeof(int))];
+   memset(control, 0, sizeof(control));
+
+   struct msghdr message;
+   memset(&message, 0, sizeof(message));
+   message.msg_iov = &iov;
+   message.msg_iovlen = 1;
+   message.msg_control = control;
+   message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+
+   struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+   header->cmsg_level = SOL_SOCKET;
+   header->cmsg_type = SCM_RIGHTS;
+   header->cmsg_len = CMSG_LEN(count * sizeof(int));
+   memcpy(CMSG_DATA(header), fds, count * sizeof(int));
+
+   return sendmsg(socket, &message, 0) == size;
+}
+
+/* Receive Descriptors
+ * Receives data together with file descriptors.
+ *
+ * <socket> unix socket
+ * <data> buffer for the bytes
+ * <size> byte count
+ * <fds> buffer for the descriptors
+ * <count> maximum descriptor count
+ * <return> descriptors received, -1 on failure
+ */
+int receiveDescriptors(int socket, void *data, int size, int *fds, int count)
+{
+   struct iovec iov = { data, (size_t)size };
+   char control[CMSG_SPACE(2 * sizeof(int))];
+
+   struct msghdr message;
+   memset(&message, 0, sizeof(message));
+   message.msg_iov = &iov;
+   message.msg_iovlen = 1;
+   message.msg_control = control;
+   message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+
+   if(recvmsg(socket, &message, MSG_WAITALL) != size)
+      return -1;
+
+   struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+   if(header == NULL || header->cmsg_type != SCM_RIGHTS)
+      return 0;
+
+   int received = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+   memcpy(fds, CMSG_DATA(header), received * sizeof(int));
+   return received;
+}